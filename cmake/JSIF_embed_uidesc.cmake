@@ -0,0 +1,216 @@
+# Compiles a JSON uidesc into a C++ header holding it as XML uidesc, so the
+# editor can parse it from memory with VSTGUI's XML parser (the only parser
+# UIDescription runs on a content provider) instead of locating and reading
+# the resource file.
+#
+# cmake -DINPUT=<file.uidesc> -DOUTPUT=<header.h> -DSYMBOL=<name> -P JSIF_embed_uidesc.cmake
+
+cmake_policy(VERSION 3.14)
+
+if(NOT INPUT OR NOT OUTPUT OR NOT SYMBOL)
+    message(FATAL_ERROR "INPUT, OUTPUT and SYMBOL must be set")
+endif()
+
+file(READ "${INPUT}" content)
+
+# The editor saves every value as a string without escapes, string(JSON)
+# cannot be used as "children" repeats keys (one per view of a class).
+if(content MATCHES "\\\\")
+    message(FATAL_ERROR "${INPUT}: escaped characters are not supported")
+endif()
+
+# escape for XML, then hide the characters CMake lists treat specially
+# behind control characters, put back when the XML is written
+string(ASCII 1 semicolon)
+string(ASCII 2 open)
+string(ASCII 3 close)
+string(REPLACE "&" "&amp;" content "${content}")
+string(REPLACE "<" "&lt;" content "${content}")
+string(REPLACE ">" "&gt;" content "${content}")
+string(REPLACE ";" "${semicolon}" content "${content}")
+string(REPLACE "[" "${open}" content "${content}")
+string(REPLACE "]" "${close}" content "${content}")
+
+string(REGEX MATCHALL "\"[^\"]*\"|[{}:,${open}${close}]|[-+.0-9A-Za-z]+" tokens "${content}")
+set(pos 0)
+
+macro(_uidesc_next var)
+    list(GET tokens ${pos} ${var})
+    math(EXPR pos "${pos} + 1")
+endmacro()
+
+macro(_uidesc_expect expected)
+    _uidesc_next(_token)
+    if(NOT _token STREQUAL "${expected}")
+        message(FATAL_ERROR "${INPUT}: expected ${expected}, found ${_token} at token ${pos}")
+    endif()
+endmacro()
+
+# "key" : or the closing } of the object, separators are skipped
+macro(_uidesc_key var)
+    _uidesc_next(${var})
+    if(${var} STREQUAL ",")
+        _uidesc_next(${var})
+    endif()
+    if(NOT ${var} STREQUAL "}")
+        string(REGEX REPLACE "^\"(.*)\"$" "\\1" ${var} "${${var}}")
+        _uidesc_expect(":")
+    endif()
+endmacro()
+
+macro(_uidesc_value var)
+    _uidesc_next(${var})
+    string(REGEX REPLACE "^\"(.*)\"$" "\\1" ${var} "${${var}}")
+endmacro()
+
+# { "name": "value", ... } as ' name="value"...'
+function(_uidesc_attributes out)
+    set(attributes "")
+    _uidesc_expect("{")
+    _uidesc_key(key)
+    while(NOT key STREQUAL "}")
+        _uidesc_value(value)
+        string(APPEND attributes " ${key}=\"${value}\"")
+        _uidesc_key(key)
+    endwhile()
+    set(${out} "${attributes}" PARENT_SCOPE)
+    set(pos ${pos} PARENT_SCOPE)
+endfunction()
+
+# { "attributes": {...}, "children": { "class": {...}, ... } } as an element
+function(_uidesc_view element name out)
+    set(xml "<${element}")
+    if(NOT name STREQUAL "")
+        string(APPEND xml " name=\"${name}\"")
+    endif()
+    set(children "")
+    _uidesc_expect("{")
+    _uidesc_key(key)
+    while(NOT key STREQUAL "}")
+        if(key STREQUAL "attributes")
+            if(NOT children STREQUAL "")
+                message(FATAL_ERROR "${INPUT}: attributes after children in ${element} ${name}")
+            endif()
+            _uidesc_attributes(attributes)
+            string(APPEND xml "${attributes}")
+        elseif(key STREQUAL "children")
+            _uidesc_expect("{")
+            _uidesc_key(class)
+            while(NOT class STREQUAL "}")
+                _uidesc_view(view "" child)
+                string(APPEND children "${child}")
+                _uidesc_key(class)
+            endwhile()
+        else()
+            message(FATAL_ERROR "${INPUT}: unknown key ${key} in ${element} ${name}")
+        endif()
+        _uidesc_key(key)
+    endwhile()
+    if(children STREQUAL "")
+        string(APPEND xml "/>")
+    else()
+        string(APPEND xml ">${children}</${element}>")
+    endif()
+    set(${out} "${xml}" PARENT_SCOPE)
+    set(pos ${pos} PARENT_SCOPE)
+endfunction()
+
+set(xml "")
+set(version "1")
+_uidesc_expect("{")
+_uidesc_key(key)
+if(NOT key STREQUAL "vstgui-ui-description")
+    message(FATAL_ERROR "${INPUT}: not a JSON uidesc")
+endif()
+_uidesc_expect("{")
+_uidesc_key(section)
+while(NOT section STREQUAL "}")
+    if(section STREQUAL "version")
+        _uidesc_value(version)
+    elseif(section STREQUAL "bitmaps" OR section STREQUAL "fonts" OR section STREQUAL "custom")
+        set(element_bitmaps bitmap)
+        set(element_fonts font)
+        set(element_custom attributes)
+        string(APPEND xml "<${section}>")
+        _uidesc_expect("{")
+        _uidesc_key(name)
+        while(NOT name STREQUAL "}")
+            _uidesc_attributes(attributes)
+            string(APPEND xml "<${element_${section}} name=\"${name}\"${attributes}/>")
+            _uidesc_key(name)
+        endwhile()
+        string(APPEND xml "</${section}>")
+    elseif(section STREQUAL "colors" OR section STREQUAL "control-tags")
+        set(element_colors color)
+        set(element_control-tags control-tag)
+        set(attribute_colors rgba)
+        set(attribute_control-tags tag)
+        string(APPEND xml "<${section}>")
+        _uidesc_expect("{")
+        _uidesc_key(name)
+        while(NOT name STREQUAL "}")
+            _uidesc_value(value)
+            string(APPEND xml "<${element_${section}} name=\"${name}\" ${attribute_${section}}=\"${value}\"/>")
+            _uidesc_key(name)
+        endwhile()
+        string(APPEND xml "</${section}>")
+    elseif(section STREQUAL "gradients")
+        string(APPEND xml "<gradients>")
+        _uidesc_expect("{")
+        _uidesc_key(name)
+        while(NOT name STREQUAL "}")
+            string(APPEND xml "<gradient name=\"${name}\">")
+            _uidesc_expect("${open}")
+            _uidesc_next(token)
+            while(NOT token STREQUAL "${close}")
+                if(NOT token STREQUAL ",")
+                    math(EXPR pos "${pos} - 1")
+                    _uidesc_attributes(attributes)
+                    string(APPEND xml "<color-stop${attributes}/>")
+                endif()
+                _uidesc_next(token)
+            endwhile()
+            string(APPEND xml "</gradient>")
+            _uidesc_key(name)
+        endwhile()
+        string(APPEND xml "</gradients>")
+    elseif(section STREQUAL "templates")
+        # templates are direct children of the root in XML
+        _uidesc_expect("{")
+        _uidesc_key(name)
+        while(NOT name STREQUAL "}")
+            _uidesc_view(template "${name}" view)
+            string(APPEND xml "${view}")
+            _uidesc_key(name)
+        endwhile()
+    else()
+        message(FATAL_ERROR "${INPUT}: unknown section ${section}")
+    endif()
+    _uidesc_key(section)
+endwhile()
+
+set(xml "<?xml version=\"1.0\" encoding=\"UTF-8\"?><vstgui-ui-description version=\"${version}\">${xml}</vstgui-ui-description>")
+string(REPLACE "${semicolon}" ";" xml "${xml}")
+string(REPLACE "${open}" "[" xml "${xml}")
+string(REPLACE "${close}" "]" xml "${xml}")
+
+get_filename_component(output_dir "${OUTPUT}" DIRECTORY)
+set(converted "${output_dir}/${SYMBOL}.xml")
+file(WRITE "${converted}" "${xml}")
+file(READ "${converted}" hex HEX)
+file(SIZE "${converted}" size)
+file(REMOVE "${converted}")
+
+string(REGEX REPLACE "(................................)" "\\1\n" hex "${hex}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated from ${INPUT}, do not edit.\n"
+"#pragma once\n"
+"\n"
+"static const unsigned char ${SYMBOL}[] = {\n${hex}\n};\n"
+"static const unsigned int ${SYMBOL}_size = ${size};\n"
+)
+# only touch the header when the uidesc really changed
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
@@ -30,6 +30,13 @@ enum {
     kParamPhase,
     kParamIn,        // ByPass
     kParamBypass,
+    kParamVuInL,        // Meters, processor -> controller, read only
+    kParamVuInR,
+    kParamVuOutL,
+    kParamVuOutR,
+    kParamVuEffect,
+    kParamLatency,      // Latency / JSIF_DSP::maxLatency, processor -> controller, read only
+    kParamLoad,         // Block time / deadline / 2, processor -> controller, read only, JSIF_ENABLE_PROFILING only
     kGuiSwitch = 1000
 };
 //------------------------------------------------------------------------
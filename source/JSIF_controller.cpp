@@ -13,6 +13,11 @@
 #include "vstgui/plugin-bindings/vst3groupcontroller.h"
 #include "vstgui/vstgui_uidescription.h"
 #include "vstgui/uidescription/detail/uiviewcreatorattributes.h"
+#include "vstgui/lib/coffscreencontext.h"
+#include "vstgui/uidescription/xmlparser.h"
+
+// JSIF_editor.uidesc compiled to XML at build time
+#include "JSIF_editor_uidesc.h"
 
 using namespace Steinberg;
 
@@ -137,21 +142,159 @@ Steinberg::tresult PLUGIN_API GUIEditor::canResize()
     return Steinberg::kResultFalse;
 }
 
+bool GUIEditor::switchTemplate(UTF8StringPtr templateName)
+{
+    CFrame* frame = getFrame();
+    CView* current = (frame && frame->getNbViews() > 0) ? frame->getView(0) : nullptr;
+    if (!current)
+        return exchangeView(templateName);
+    if (viewName == templateName)
+        return true;
+
+    SharedPointer<CView> next;
+    auto cached = templateViews.find(templateName);
+    if (cached != templateViews.end())
+        next = cached->second;
+    else
+    {
+        next = owned(getUIDescription()->createView(templateName, this));
+        if (!next)
+            return false;
+        templateViews[templateName] = next;
+    }
+
+    // keep the outgoing tree, removing it only drops the frame's reference
+    templateViews[viewName] = current;
+    frame->removeView(current, true);
+
+    CRect viewSize(next->getViewSize());
+    const double zoom = getZoomFactor();
+    CPoint newSize(viewSize.getWidth() * zoom, viewSize.getHeight() * zoom);
+    requestResize(newSize);
+    frame->setSize(newSize.x, newSize.y);
+
+    next->remember();
+    frame->addView(next);
+    frame->invalid();
+
+    viewName = templateName;
+    return true;
+}
+
+void PLUGIN_API GUIEditor::close()
+{
+    VST3Editor::close();
+    templateViews.clear();
+}
+
+void GUIEditor::prepareZoomBitmaps(double zoomFactor)
+{
+    const UIDescription* description = getUIDescription();
+    if (!description || !getFrame())
+        return;
+
+    // CBitmap::draw picks the representation closest to backing scale * zoom
+    const double scaleFactor = zoomFactor * getFrame()->getScaleFactor();
+    if (scaleFactor == 1.0)
+        return;
+
+    std::list<const std::string*> bitmapNames;
+    description->collectBitmapNames(bitmapNames);
+    for (const auto* name : bitmapNames)
+    {
+        CBitmap* bitmap = description->getBitmap(name->data());
+        if (!bitmap || !bitmap->getPlatformBitmap())
+            continue;
+
+        auto best = bitmap->getBestPlatformBitmapForScaleFactor(scaleFactor);
+        if (best && best->getScaleFactor() == scaleFactor)
+            continue;
+
+        auto offscreen = COffscreenContext::create(bitmap->getSize(), scaleFactor);
+        if (!offscreen)
+            continue;
+        offscreen->beginDraw();
+        offscreen->setBitmapInterpolationQuality(BitmapInterpolationQuality::kHigh);
+        bitmap->draw(offscreen, CRect(CPoint(0, 0), bitmap->getSize()));
+        offscreen->endDraw();
+
+        if (CBitmap* scaled = offscreen->getBitmap())
+            bitmap->addBitmap(scaled->getPlatformBitmap());
+    }
+}
+
 } // namespace VSTGUI
 
 namespace yg331 {
 
+//------------------------------------------------------------------------
+// Shared editor description
+//------------------------------------------------------------------------
+// JSIF_editor.uidesc is parsed once per process, the first editor that
+// opens parses it and every later editor of every instance reuses it, so
+// all of them draw from the same loaded bitmaps. Views are created through
+// createView() with the editor as controller, nothing in the description is
+// per editor. It is parsed from the copy compiled into the binary, not from
+// the file: cmake/JSIF_embed_uidesc.cmake converts the JSON uidesc to XML,
+// as a UIDescription on a content provider only runs the XML parser.
+static VSTGUI::SharedPointer<VSTGUI::UIDescription> sharedDescription;
+static int32 sharedDescriptionUsers = 0;
+
+static VSTGUI::UIDescription* parseEditorDescription()
+{
+    VSTGUI::Xml::MemoryContentProvider content(kJSIF_editor_uidesc, kJSIF_editor_uidesc_size);
+    auto* description = new VSTGUI::UIDescription(&content);
+    if (!description->parse())
+    {
+        description->forget();
+        return nullptr;
+    }
+    return description;
+}
+
+static VSTGUI::UIDescription* sharedEditorDescription()
+{
+    if (!sharedDescription)
+        sharedDescription = VSTGUI::owned(parseEditorDescription());
+    return sharedDescription;
+}
+
 //------------------------------------------------------------------------
 // VuMeterController
 //------------------------------------------------------------------------
+// Pushes a value only if it moves the drawn bar, and keeps invalidating
+// while CVuMeter is still falling back by its decrease-step-value.
+static void setVuMeterValue(VSTGUI::CControl* meter, float value)
+{
+    if (!meter || !meter->isAttached())
+        return;
+
+    if (auto* vuMeter = dynamic_cast<VSTGUI::CVuMeter*>(meter))
+    {
+        const float nbLed = static_cast<float>(vuMeter->getNbLed());
+        const int32 drawn = static_cast<int32>(nbLed * vuMeter->getValueNormalized() + 0.5f);
+        const int32 level = static_cast<int32>(nbLed * value + 0.5f);
+        if (drawn != level)
+            vuMeter->setValueNormalized(value);
+        if (drawn != level || vuMeter->getOldValue() > vuMeter->getValue())
+            vuMeter->invalid();
+    }
+    else if (auto* myVuMeter = dynamic_cast<VSTGUI::MyVuMeter*>(meter))
+    {
+        myVuMeter->setValueNormalized(value);
+        if (myVuMeter->needsRedraw())
+            myVuMeter->invalid();
+    }
+}
+
 template<> void JSIF_Controller::UIVuMeterController::updateVuMeterValue()
 {
     if (mainController) {
-        if (vuMeterInL)       vuMeterInL->   setValueNormalized(mainController->getVuMeterByTag(VuMeter_inL));
-        if (vuMeterInR)       vuMeterInR->   setValueNormalized(mainController->getVuMeterByTag(VuMeter_inR));
-        if (vuMeterOutL)      vuMeterOutL->  setValueNormalized(mainController->getVuMeterByTag(VuMeter_outL));
-        if (vuMeterOutR)      vuMeterOutR->  setValueNormalized(mainController->getVuMeterByTag(VuMeter_outR));
-        if (vuMeterEffect)    vuMeterEffect->setValueNormalized(mainController->getVuMeterByTag(VuMeter_effect));
+        setVuMeterValue(vuMeterInL,    static_cast<float>(mainController->getVuMeterByTag(VuMeter_inL)));
+        setVuMeterValue(vuMeterInR,    static_cast<float>(mainController->getVuMeterByTag(VuMeter_inR)));
+        setVuMeterValue(vuMeterOutL,   static_cast<float>(mainController->getVuMeterByTag(VuMeter_outL)));
+        setVuMeterValue(vuMeterOutR,   static_cast<float>(mainController->getVuMeterByTag(VuMeter_outR)));
+        setVuMeterValue(vuMeterEffect, static_cast<float>(mainController->getVuMeterByTag(VuMeter_effect)));
     }
 }
 
@@ -161,7 +304,10 @@ template<> VSTGUI::CView* JSIF_Controller::UIVuMeterController::verifyView(
                                             const VSTGUI::IUIDescription* /*description*/
 )
 {
-    if (VSTGUI::CVuMeter* control = dynamic_cast<VSTGUI::CVuMeter*>(view); control) {
+    VSTGUI::CControl* control = dynamic_cast<VSTGUI::CVuMeter*>(view);
+    if (!control)
+        control = dynamic_cast<VSTGUI::MyVuMeter*>(view);
+    if (control) {
         if (control->getTag() == kInVuPPML)  { vuMeterInL    = control; vuMeterInL->   registerViewListener(this); }
         if (control->getTag() == kInVuPPMR)  { vuMeterInR    = control; vuMeterInR->   registerViewListener(this); }
         if (control->getTag() == kOutVuPPML) { vuMeterOutL   = control; vuMeterOutL->  registerViewListener(this); }
@@ -173,11 +319,11 @@ template<> VSTGUI::CView* JSIF_Controller::UIVuMeterController::verifyView(
 
 template<> void JSIF_Controller::UIVuMeterController::viewWillDelete(VSTGUI::CView* view)
 {
-    if (dynamic_cast<VSTGUI::CVuMeter*>(view) == vuMeterInL    && vuMeterInL)   { vuMeterInL->   unregisterViewListener(this); vuMeterInL    = nullptr; }
-    if (dynamic_cast<VSTGUI::CVuMeter*>(view) == vuMeterInR    && vuMeterInR)   { vuMeterInR->   unregisterViewListener(this); vuMeterInR    = nullptr; }
-    if (dynamic_cast<VSTGUI::CVuMeter*>(view) == vuMeterOutL   && vuMeterOutL)  { vuMeterOutL->  unregisterViewListener(this); vuMeterOutL   = nullptr; }
-    if (dynamic_cast<VSTGUI::CVuMeter*>(view) == vuMeterOutR   && vuMeterOutR)  { vuMeterOutR->  unregisterViewListener(this); vuMeterOutR   = nullptr; }
-    if (dynamic_cast<VSTGUI::CVuMeter*>(view) == vuMeterEffect && vuMeterEffect){ vuMeterEffect->unregisterViewListener(this); vuMeterEffect = nullptr; }
+    if (view == vuMeterInL    && vuMeterInL)   { vuMeterInL->   unregisterViewListener(this); vuMeterInL    = nullptr; }
+    if (view == vuMeterInR    && vuMeterInR)   { vuMeterInR->   unregisterViewListener(this); vuMeterInR    = nullptr; }
+    if (view == vuMeterOutL   && vuMeterOutL)  { vuMeterOutL->  unregisterViewListener(this); vuMeterOutL   = nullptr; }
+    if (view == vuMeterOutR   && vuMeterOutR)  { vuMeterOutR->  unregisterViewListener(this); vuMeterOutR   = nullptr; }
+    if (view == vuMeterEffect && vuMeterEffect){ vuMeterEffect->unregisterViewListener(this); vuMeterEffect = nullptr; }
 }
 
 //------------------------------------------------------------------------
@@ -277,6 +423,7 @@ tresult PLUGIN_API JSIF_Controller::initialize(FUnknown* context)
 	{
 		return result;
 	}
+	sharedDescriptionUsers++;
 
 	int32 stepCount;
 	int32 flags;
@@ -365,6 +512,20 @@ tresult PLUGIN_API JSIF_Controller::initialize(FUnknown* context)
     flags        = Vst::ParameterInfo::kIsBypass;
     parameters.addParameter(STR16("Bypass"), nullptr, stepCount, defaultVal, flags, tag);
 
+    // Meters and latency, sent by the processor as output parameter changes
+    stepCount    = 0;
+    defaultVal   = 0;
+    flags        = Vst::ParameterInfo::kIsReadOnly | Vst::ParameterInfo::kIsHidden;
+    parameters.addParameter(STR16("VU In L"),    nullptr, stepCount, defaultVal, flags, kParamVuInL);
+    parameters.addParameter(STR16("VU In R"),    nullptr, stepCount, defaultVal, flags, kParamVuInR);
+    parameters.addParameter(STR16("VU Out L"),   nullptr, stepCount, defaultVal, flags, kParamVuOutL);
+    parameters.addParameter(STR16("VU Out R"),   nullptr, stepCount, defaultVal, flags, kParamVuOutR);
+    parameters.addParameter(STR16("VU Effect"),  nullptr, stepCount, defaultVal, flags, kParamVuEffect);
+    parameters.addParameter(STR16("Latency"),    nullptr, stepCount, defaultVal, flags, kParamLatency);
+#ifdef JSIF_ENABLE_PROFILING
+    parameters.addParameter(STR16("DSP Load"),   nullptr, stepCount, defaultVal, flags, kParamLoad);
+#endif
+
 	// GUI only parameter
 	if (zoomFactors.empty())
 	{
@@ -402,6 +563,13 @@ tresult PLUGIN_API JSIF_Controller::terminate()
 	// Here the Plug-in will be de-instantiated, last possibility to remove some memory!
 	getParameterObject(kParamZoom)->removeDependent(this);
 	getParameterObject(kGuiSwitch)->removeDependent(this);
+	if (meterTimer)
+	{
+		meterTimer->stop();
+		meterTimer = nullptr;
+	}
+	if (--sharedDescriptionUsers == 0)
+		sharedDescription = nullptr;
 	//---do not forget to call parent ------
 	return EditControllerEx1::terminate();
 }
@@ -582,11 +750,20 @@ IPlugView* PLUGIN_API JSIF_Controller::createView(FIDString name)
 	if (FIDStringsEqual(name, Vst::ViewType::kEditor))
 	{
         VSTGUI::GUIEditor* view;
+        VSTGUI::UTF8StringPtr templateName = (stateGUI == 0.0) ? "Original" : "Twarch";
 		// create your editor here and return a IPlugView ptr of it
-		if (stateGUI == 0.0) 
-			view = new VSTGUI::GUIEditor(this, "Original", "JSIF_editor.uidesc");
+#if VSTGUI_LIVE_EDITING
+		view = new VSTGUI::GUIEditor(this, templateName, "JSIF_editor.uidesc");
+#else
+		auto description = sharedEditorDescription();
+		if (description)
+			view = new VSTGUI::GUIEditor(description, this, templateName, "JSIF_editor.uidesc");
 		else
-			view = new VSTGUI::GUIEditor(this, "Twarch", "JSIF_editor.uidesc");
+		{
+			FDebugPrint("[ JSIF ] compiled JSIF_editor.uidesc did not parse, loading the resource file\n");
+			view = new VSTGUI::GUIEditor(this, templateName, "JSIF_editor.uidesc");
+		}
+#endif
         view->setGuiState(stateGUI);
         
         std::vector<double> _zoomFactors;
@@ -623,21 +800,6 @@ VSTGUI::IController* JSIF_Controller::createSubController(
 };
 
 
-//------------------------------------------------------------------------
-tresult JSIF_Controller::receiveText(const char* text)
-{
-	// received from Component
-	if (text)
-	{	
-		// Latency report
-		if (strcmp("OS\n", text)) {
-            getComponentHandler()->restartComponent(Vst::kLatencyChanged);
-            //FDebugPrint("[ FDebugPrint ] restartComponent\n");
-		}
-	}		
-	return kResultOk;
-}
-	
 //------------------------------------------------------------------------
 void PLUGIN_API JSIF_Controller::update(FUnknown* changedUnknown, int32 message)
 {
@@ -660,6 +822,8 @@ void PLUGIN_API JSIF_Controller::update(FUnknown* changedUnknown, int32 message)
 
 		for (EditorVector::const_iterator it = editors.begin(), end = editors.end(); it != end; ++it)
 		{
+			if (VSTGUI::GUIEditor* guiEditor = dynamic_cast<VSTGUI::GUIEditor*>(*it))
+				guiEditor->prepareZoomBitmaps(zoomFactors[index].factor);
 			VSTGUI::VST3Editor* editor = dynamic_cast<VSTGUI::VST3Editor*>(*it);
 			if (editor)
 				editor->setZoomFactor(zoomFactors[index].factor);
@@ -680,8 +844,8 @@ void PLUGIN_API JSIF_Controller::update(FUnknown* changedUnknown, int32 message)
             VSTGUI::GUIEditor* editor = dynamic_cast<VSTGUI::GUIEditor*>(*it);
             if (editor) {
                 if (editor->getGuiState() != stateGUI) {
-                    if      (stateGUI == 0.0) editor->exchangeView("Original");
-                    else if (stateGUI == 1.0) editor->exchangeView("Twarch");
+                    if      (stateGUI == 0.0) editor->switchTemplate("Original");
+                    else if (stateGUI == 1.0) editor->switchTemplate("Twarch");
                     editor->setGuiState(stateGUI);
                 }
             }
@@ -695,10 +859,11 @@ void JSIF_Controller::editorAttached(Steinberg::Vst::EditorView* editor)
     VSTGUI::GUIEditor* _editor = dynamic_cast<VSTGUI::GUIEditor*>(editor);
     if (_editor) {
         if (_editor->getGuiState() != stateGUI) {
-            if      (stateGUI == 0.0) _editor->exchangeView("Original");
-            else if (stateGUI == 1.0) _editor->exchangeView("Twarch");
+            if      (stateGUI == 0.0) _editor->switchTemplate("Original");
+            else if (stateGUI == 1.0) _editor->switchTemplate("Twarch");
             _editor->setGuiState(stateGUI);
         }
+        _editor->prepareZoomBitmaps(_editor->getZoomFactor());
     }
 	editors.push_back(_editor);
 }
@@ -714,9 +879,81 @@ tresult PLUGIN_API JSIF_Controller::setParamNormalized(Vst::ParamID tag, Vst::Pa
 {
 	// called by host to update your parameters
 	tresult result = EditControllerEx1::setParamNormalized(tag, value);
+
+	// output parameters of the processor, meters are redrawn by meterTimer
+	switch (tag) {
+	case kParamVuInL:    vuInL    = value; break;
+	case kParamVuInR:    vuInR    = value; break;
+	case kParamVuOutL:   vuOutL   = value; break;
+	case kParamVuOutR:   vuOutR   = value; break;
+	case kParamVuEffect: vuEffect = value; break;
+	case kParamLatency:
+		if (value != reportedLatency)
+		{
+			reportedLatency = value;
+			if (getComponentHandler())
+				getComponentHandler()->restartComponent(Vst::kLatencyChanged);
+		}
+		break;
+#ifdef JSIF_ENABLE_PROFILING
+	case kParamLoad:
+		load = value;
+		requestProfile(value > 0.5);
+		break;
+#endif
+	}
 	return result;
 }
 
+#ifdef JSIF_ENABLE_PROFILING
+//------------------------------------------------------------------------
+void JSIF_Controller::requestProfile(bool overrun)
+{
+	// once a second, faster while blocks miss their deadline
+	auto now = std::chrono::steady_clock::now();
+	auto interval = overrun ? std::chrono::milliseconds(100) : std::chrono::milliseconds(1000);
+	if (now - lastProfileRequest < interval)
+		return;
+	lastProfileRequest = now;
+
+	if (IPtr<Vst::IMessage> message = owned(allocateMessage()))
+	{
+		message->setMessageID(kMsgProfileRequest);
+		sendMessage(message);
+	}
+}
+
+//------------------------------------------------------------------------
+tresult PLUGIN_API JSIF_Controller::notify(Vst::IMessage* message)
+{
+	if (!message)
+		return kInvalidArgument;
+
+	if (FIDStringsEqual(message->getMessageID(), kMsgProfile))
+	{
+		const void* data = nullptr;
+		uint32 size = 0;
+		if (message->getAttributes()->getBinary(kMsgProfile, data, size) == kResultOk &&
+		    size == sizeof(JSIF_Profiler::Snapshot))
+		{
+			memcpy(&profile, data, size);
+			if (profile.overruns > loggedOverruns)
+			{
+				FDebugPrint("[ JSIF ] instance %u: %llu of %llu blocks over deadline, worst load %.2f, heaviest stage %s\n",
+				            profile.instance,
+				            (unsigned long long)profile.overruns,
+				            (unsigned long long)profile.blocks,
+				            profile.maxLoad,
+				            JSIF_Profiler::stageName(profile.maxLoadStage));
+				loggedOverruns = profile.overruns;
+			}
+		}
+		return kResultOk;
+	}
+	return EditControllerEx1::notify(message);
+}
+#endif
+
 //------------------------------------------------------------------------
 tresult PLUGIN_API JSIF_Controller::getParamStringByValue(Vst::ParamID tag, Vst::ParamValue valueNormalized, Vst::String128 string)
 {
@@ -733,31 +970,4 @@ tresult PLUGIN_API JSIF_Controller::getParamValueByString(Vst::ParamID tag, Vst:
 	return EditControllerEx1::getParamValueByString(tag, string, valueNormalized);
 }
 
-//------------------------------------------------------------------------
-tresult PLUGIN_API JSIF_Controller::notify(Vst::IMessage* message)
-{
-    if (!message)
-        return kInvalidArgument;
-    
-    if (strcmp (message->getMessageID (), "VUmeter") == 0)
-    {
-        double data = 0.0;
-        int64 update = 0.0;
-        if (message->getAttributes ()->getFloat ("vuInL",    data) == kResultTrue) vuInL    = data;
-        if (message->getAttributes ()->getFloat ("vuInR",    data) == kResultTrue) vuInR    = data;
-        if (message->getAttributes ()->getFloat ("vuOutL",   data) == kResultTrue) vuOutL   = data;
-        if (message->getAttributes ()->getFloat ("vuOutR",   data) == kResultTrue) vuOutR   = data;
-        if (message->getAttributes ()->getFloat ("vuEffect", data) == kResultTrue) vuEffect = data;
-        if (message->getAttributes ()->getInt   ("update", update) == kResultTrue) {
-            if (!vuMeterControllers.empty()) {
-                for (auto iter = vuMeterControllers.begin(); iter != vuMeterControllers.end(); iter++) {
-                    (*iter)->updateVuMeterValue();
-                }
-            }
-        }
-        return kResultOk;
-    }
-
-	return EditControllerEx1::notify(message);
-}
 } // namespace yg331
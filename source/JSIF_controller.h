@@ -10,9 +10,14 @@
 #include "vstgui/plugin-bindings/vst3editor.h"
 #include "vstgui/plugin-bindings/vst3groupcontroller.h"
 #include "vstgui/uidescription/delegationcontroller.h"
+#include "vstgui/lib/cvstguitimer.h"
 
 #include "base/source/fobject.h"
 
+#include <map>
+#include <string>
+#include <chrono>
+
 namespace VSTGUI {
 //------------------------------------------------------------------------
 //  VU meter view
@@ -40,8 +45,6 @@ public:
 
         rectOn(size.left, size.top, size.right, size.bottom);
         rectOff(size.left, size.top, size.right, size.bottom);
-
-        setWantsIdle(true);
     }
     MyVuMeter(const MyVuMeter& vuMeter)
         : CControl(vuMeter)
@@ -50,9 +53,7 @@ public:
         , vuOffColor(vuMeter.vuOffColor)
         , rectOn(vuMeter.rectOn)
         , rectOff(vuMeter.rectOff)
-    {
-        setWantsIdle(true);
-    }
+    {}
 
     void setStyle(int32_t newStyle) { style = newStyle; invalid(); }
     int32_t getStyle() const { return style; }
@@ -82,6 +83,7 @@ public:
         bounceValue();
 
         float newValue = getValueNormalized(); // normalize
+        drawnLevel = getQuantizedLevel(newValue);
 
         if (style & kHorizontal)
         {
@@ -128,9 +130,15 @@ public:
         return false;
     };
     
-    void onIdle() override {
-        invalid();
-    };
+    // on-screen bar length in whole pixels, the only thing a redraw can change
+    int32_t getQuantizedLevel(float normValue) const {
+        if (style & kHorizontal)
+            return (int32_t)(normValue * getViewSize().getWidth());
+        return (int32_t)(normValue * getViewSize().getHeight());
+    }
+    bool needsRedraw() const {
+        return getQuantizedLevel(getValueNormalized()) != drawnLevel;
+    }
     
     CLASS_METHODS(MyVuMeter, CControl)
 
@@ -148,6 +156,8 @@ protected:
 
     CRect    rectOn;
     CRect    rectOff;
+
+    int32_t  drawnLevel = -1;
 };
 
 class GUIEditor : public VST3Editor
@@ -157,13 +167,28 @@ public:
 
     GUIEditor(EditController* controller, UTF8StringPtr templateName, UTF8StringPtr xmlFile)
         : VSTGUI::VST3Editor(controller, templateName, xmlFile) {}
+    GUIEditor(UIDescription* desc, EditController* controller, UTF8StringPtr templateName, UTF8StringPtr xmlFile)
+        : VSTGUI::VST3Editor(desc, controller, templateName, xmlFile) {}
 
     Steinberg::tresult PLUGIN_API canResize() SMTG_OVERRIDE;
+    // drops the hidden templates with the frame, reopening builds them again
+    void PLUGIN_API close() SMTG_OVERRIDE;
+
+    // swaps the frame content to templateName, each template is built once
+    // per open editor and kept alive while hidden. Like exchangeView it sets
+    // the view name, so the editor reopens on the template last shown
+    bool switchTemplate(UTF8StringPtr templateName);
+
+    // adds a pre-scaled representation of every uidesc bitmap for this zoom,
+    // so drawing at that zoom blits instead of resampling each frame
+    void prepareZoomBitmaps(double zoomFactor);
     
     double getGuiState() {return guiState;}
     void   setGuiState(double newState) {guiState = newState;}
 protected:
     double guiState = 0.0;
+
+    std::map<std::string, SharedPointer<CView>> templateViews;
 };
 
 }
@@ -222,11 +247,11 @@ private:
     void viewWillDelete(CView* view) SMTG_OVERRIDE;
 
 	ControllerType* mainController;
-    CVuMeter* vuMeterInL;
-    CVuMeter* vuMeterInR;
-    CVuMeter* vuMeterOutL;
-    CVuMeter* vuMeterOutR;
-    CVuMeter* vuMeterEffect;
+    CControl* vuMeterInL;
+    CControl* vuMeterInR;
+    CControl* vuMeterOutL;
+    CControl* vuMeterOutR;
+    CControl* vuMeterEffect;
 };
 
 //------------------------------------------------------------------------
@@ -292,9 +317,11 @@ public:
 		                                                    Steinberg::Vst::ParamValue& valueNormalized) SMTG_OVERRIDE;
 
 	//---from ComponentBase-----
-	// EditController
+#ifdef JSIF_ENABLE_PROFILING
+	/** Receives the processor's JSIF_Profiler::Snapshot */
 	Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
-	Steinberg::tresult PLUGIN_API receiveText(const char* text) SMTG_OVERRIDE;
+#endif
+	// EditController
 	void PLUGIN_API update(Steinberg::FUnknown* changedUnknown, Steinberg::int32 message) SMTG_OVERRIDE;
 	void editorAttached(Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE; ///< called from EditorView if it was attached to a parent
 	void editorRemoved (Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE; ///< called from EditorView if it was removed from a parent
@@ -361,12 +388,27 @@ public:
 	void addUIVuMeterController(UIVuMeterController* controller)
 	{
 		vuMeterControllers.push_back(controller);
+		if (!meterTimer)
+		{
+			// one timer drives every meter of the editor, messages only store values
+			meterTimer = VSTGUI::makeOwned<VSTGUI::CVSTGUITimer>(
+				[this](VSTGUI::CVSTGUITimer*) {
+					for (auto& iter : vuMeterControllers)
+						iter->updateVuMeterValue();
+				},
+				getMeterFireTime(), true);
+		}
 	};
 	void removeUIVuMeterController(UIVuMeterController* controller)
 	{
 		auto it = std::find(vuMeterControllers.begin(), vuMeterControllers.end(), controller);
 		if (it != vuMeterControllers.end())
 			vuMeterControllers.erase(it);
+		if (vuMeterControllers.empty() && meterTimer)
+		{
+			meterTimer->stop();
+			meterTimer = nullptr;
+		}
 	};
     Steinberg::Vst::ParamValue getVuMeterByTag(Steinberg::Vst::ParamID tag)
     {
@@ -380,6 +422,11 @@ public:
         }
         return 0;
     }
+#ifdef JSIF_ENABLE_PROFILING
+	/** Last statistics received from the processor, refreshed while kParamLoad arrives */
+	const JSIF_Profiler::Snapshot& getProfile() const { return profile; }
+	Steinberg::Vst::ParamValue getLoad() const { return load * 2.0; }
+#endif
     
 	//---Interface---------
 	DEFINE_INTERFACES
@@ -411,6 +458,11 @@ private:
 	// sub-controller list
 	using UIVuMeterControllerList = std::vector<UIVuMeterController*>;
 	UIVuMeterControllerList vuMeterControllers;
+
+	// shared meter refresh
+	static constexpr double kMeterFrameRate = 30.0;
+	VSTGUI::SharedPointer<VSTGUI::CVSTGUITimer> meterTimer;
+	static constexpr uint32_t getMeterFireTime() { return static_cast<uint32_t>(1000.0 / kMeterFrameRate); }
     
     // AUv2 - state saving
     Steinberg::Vst::ParamValue stateInput  = 0.0;
@@ -427,7 +479,18 @@ private:
 
 	Steinberg::Vst::ParamValue stateGUI    = 0.0;
     
+    // written by the processor through the read only kParamVu* parameters
     Steinberg::Vst::ParamValue vuInL = 0.0, vuInR = 0.0, vuOutL = 0.0, vuOutR = 0.0, vuEffect = 0.0;
+    Steinberg::Vst::ParamValue reportedLatency = -1.0;  // none received yet, the first one restarts
+
+#ifdef JSIF_ENABLE_PROFILING
+	void requestProfile(bool overrun);
+
+	JSIF_Profiler::Snapshot profile;
+	Steinberg::Vst::ParamValue load = 0.0;
+	uint64_t loggedOverruns = 0;
+	std::chrono::steady_clock::time_point lastProfileRequest;
+#endif
 };
 	
 } // namespace yg331
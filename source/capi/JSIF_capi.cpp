@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "JSIF_capi.h"
+#include "JSIF_dsp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+using namespace yg331;
+
+static_assert(JSIF_PARAM_INPUT  == (int)JSIF_DSP::kInput  && JSIF_PARAM_EFFECT == (int)JSIF_DSP::kEffect &&
+              JSIF_PARAM_CURVE  == (int)JSIF_DSP::kCurve  && JSIF_PARAM_CLIP   == (int)JSIF_DSP::kClip   &&
+              JSIF_PARAM_OUTPUT == (int)JSIF_DSP::kOutput && JSIF_PARAM_OS     == (int)JSIF_DSP::kOS     &&
+              JSIF_PARAM_SPLIT  == (int)JSIF_DSP::kSplit  && JSIF_PARAM_PHASE  == (int)JSIF_DSP::kPhase  &&
+              JSIF_PARAM_IN     == (int)JSIF_DSP::kIn     && JSIF_PARAM_BYPASS == (int)JSIF_DSP::kBypass &&
+              JSIF_PARAM_COUNT  == (int)JSIF_DSP::kNumParams,
+              "jsif_param must follow JSIF_DSP::Param");
+
+//------------------------------------------------------------------------
+// Parameters go through lock-free slots: set_param stores the value and
+// marks it, process hands the marked ones to the DSP before the block. So
+// a control thread never touches JSIF_DSP while it processes.
+struct jsif_instance
+{
+	JSIF_DSP dsp;
+	std::atomic<double>   values[JSIF_PARAM_COUNT];
+	std::atomic<uint32_t> changed { 0 };
+	bool                  prepared    = false;
+	int32_t               numChannels = 0;
+
+	jsif_instance()
+	{
+		for (int id = 0; id < JSIF_PARAM_COUNT; id++)
+			values[id].store(dsp.getParam((JSIF_DSP::Param)id), std::memory_order_relaxed);
+		dsp.setMetering(false);
+	}
+
+	void applyChanges()
+	{
+		uint32_t mask = changed.exchange(0, std::memory_order_acquire);
+		for (int id = 0; mask != 0; id++, mask >>= 1)
+			if (mask & 1u)
+				dsp.setParam((JSIF_DSP::Param)id, values[id].load(std::memory_order_relaxed));
+	}
+
+	template <typename SampleType>
+	jsif_result process(const SampleType* const* in, SampleType* const* out, int32_t channels, int32_t frames)
+	{
+		if (!in || !out || channels < 0 || frames < 0) return JSIF_ERROR_INVALID_ARGUMENT;
+		if (!prepared) return JSIF_ERROR_NOT_PREPARED;
+		if (channels > numChannels) return JSIF_ERROR_INVALID_ARGUMENT;
+		for (int32_t ch = 0; ch < channels; ch++)
+			if (!in[ch] || !out[ch]) return JSIF_ERROR_INVALID_ARGUMENT;
+
+		applyChanges();
+		// JSIF_DSP only reads the inputs
+		dsp.process(const_cast<SampleType**>(in), const_cast<SampleType**>(out), channels, frames);
+		return JSIF_OK;
+	}
+};
+
+//------------------------------------------------------------------------
+extern "C" {
+
+uint32_t jsif_api_version(void)
+{
+	return JSIF_API_VERSION;
+}
+
+jsif_instance* jsif_create(void)
+{
+	try {
+		return new jsif_instance();
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void jsif_destroy(jsif_instance* instance)
+{
+	delete instance;
+}
+
+jsif_result jsif_prepare(jsif_instance* instance, double sample_rate, int32_t channels, int32_t max_block)
+{
+	if (!instance || !(sample_rate > 0.0) || channels < 1 || max_block < 1)
+		return JSIF_ERROR_INVALID_ARGUMENT;
+	try {
+		instance->prepared = false;
+		instance->applyChanges();
+		instance->dsp.prepare(sample_rate, channels, max_block);
+	}
+	catch (const std::bad_alloc&) {
+		return JSIF_ERROR_OUT_OF_MEMORY;
+	}
+	instance->numChannels = channels;
+	instance->prepared    = true;
+	return JSIF_OK;
+}
+
+jsif_result jsif_process_f32(jsif_instance* instance, const float* const* in, float* const* out, int32_t channels, int32_t frames)
+{
+	return instance ? instance->process(in, out, channels, frames) : JSIF_ERROR_INVALID_ARGUMENT;
+}
+
+jsif_result jsif_process_f64(jsif_instance* instance, const double* const* in, double* const* out, int32_t channels, int32_t frames)
+{
+	return instance ? instance->process(in, out, channels, frames) : JSIF_ERROR_INVALID_ARGUMENT;
+}
+
+jsif_result jsif_set_param(jsif_instance* instance, jsif_param id, double value)
+{
+	if (!instance || id < 0 || id >= JSIF_PARAM_COUNT || value != value)
+		return JSIF_ERROR_INVALID_ARGUMENT;
+	instance->values[id].store(std::min(1.0, std::max(0.0, value)), std::memory_order_relaxed);
+	instance->changed.fetch_or(1u << id, std::memory_order_release);
+	return JSIF_OK;
+}
+
+double jsif_get_param(const jsif_instance* instance, jsif_param id)
+{
+	if (!instance || id < 0 || id >= JSIF_PARAM_COUNT)
+		return -1.0;
+	return instance->values[id].load(std::memory_order_relaxed);
+}
+
+jsif_result jsif_reset(jsif_instance* instance)
+{
+	if (!instance) return JSIF_ERROR_INVALID_ARGUMENT;
+	if (!instance->prepared) return JSIF_ERROR_NOT_PREPARED;
+	instance->dsp.reset();
+	return JSIF_OK;
+}
+
+int32_t jsif_get_latency(const jsif_instance* instance)
+{
+	if (!instance) return -1;
+	overSample os = JSIF_DSP::overSampleFromNormalized(instance->values[JSIF_PARAM_OS].load(std::memory_order_relaxed));
+	bool linear   = instance->values[JSIF_PARAM_PHASE].load(std::memory_order_relaxed) > 0.5;
+	return JSIF_DSP::latencyFor(os, linear);
+}
+
+} // extern "C"
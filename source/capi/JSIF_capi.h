@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// C ABI of the Inflator signal path, for embedding it without the VST3
+// layer and for other languages through FFI. Built as the jsif shared
+// library, only the jsif_* functions below are exported.
+//
+// Stability: functions are only ever added. A library with a higher
+// JSIF_API_VERSION keeps every function, enum value and behaviour of a
+// lower one, jsif_api_version() tells what the loaded library provides.
+// No struct crosses the boundary, jsif_instance is opaque.
+//
+// Audio is planar and owned by the caller: process reads in[ch] and writes
+// out[ch] directly, nothing is copied. in and out may be the same arrays
+// (in place), but a channel may not overlap another channel's buffer.
+// A call may pass more frames than max_block, it is split internally, and
+// fewer channels than prepared.
+//
+// Thread safety:
+//  - Distinct instances share nothing mutable and may be used from any
+//    threads at the same time.
+//  - jsif_prepare, jsif_process_f32/f64, jsif_reset and jsif_destroy on one
+//    instance must not overlap, the library does not lock. They may be
+//    called from different threads one after the other.
+//  - jsif_set_param, jsif_get_param and jsif_get_latency may be called from
+//    any thread at any time, also while jsif_process_* runs. They are lock
+//    free. A parameter set during a process call takes effect at the start
+//    of the next one; jsif_get_param and jsif_get_latency report the values
+//    last set.
+//
+// Real-time safety: jsif_create and jsif_prepare allocate. After prepare,
+// jsif_process_*, jsif_reset and the parameter calls neither allocate nor
+// block. Meters are off, the library has no meter output.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+	#if defined(JSIF_CAPI_BUILD)
+		#define JSIF_CAPI __declspec(dllexport)
+	#else
+		#define JSIF_CAPI __declspec(dllimport)
+	#endif
+#elif defined(__GNUC__)
+	#define JSIF_CAPI __attribute__((visibility("default")))
+#else
+	#define JSIF_CAPI
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSIF_API_VERSION 1
+
+typedef struct jsif_instance jsif_instance;
+
+/** Parameters, all normalized 0..1 like the plug-in's. */
+typedef enum jsif_param {
+	JSIF_PARAM_INPUT  = 0,  /* -12..+12 dB                      */
+	JSIF_PARAM_EFFECT = 1,  /* dry/wet                          */
+	JSIF_PARAM_CURVE  = 2,  /* -50..+50 %                       */
+	JSIF_PARAM_CLIP   = 3,  /* > 0.5 on                         */
+	JSIF_PARAM_OUTPUT = 4,  /* -12..0 dB                        */
+	JSIF_PARAM_OS     = 5,  /* 0, 1/3, 2/3, 1: x1, x2, x4, x8   */
+	JSIF_PARAM_SPLIT  = 6,  /* > 0.5 3 band split               */
+	JSIF_PARAM_PHASE  = 7,  /* > 0.5 linear phase (r8brain)     */
+	JSIF_PARAM_IN     = 8,  /* > 0.5 effect in                  */
+	JSIF_PARAM_BYPASS = 9,  /* > 0.5 bypassed, latency is kept  */
+	JSIF_PARAM_COUNT  = 10
+} jsif_param;
+
+typedef enum jsif_result {
+	JSIF_OK                     =  0,
+	JSIF_ERROR_INVALID_ARGUMENT = -1,  /* null pointer, unknown parameter, bad format */
+	JSIF_ERROR_NOT_PREPARED     = -2,  /* process or reset before a successful prepare */
+	JSIF_ERROR_OUT_OF_MEMORY    = -3
+} jsif_result;
+
+/** JSIF_API_VERSION of the loaded library. */
+JSIF_CAPI uint32_t jsif_api_version(void);
+
+/** A new instance with the plug-in's default parameters, NULL when out of memory. */
+JSIF_CAPI jsif_instance* jsif_create(void);
+
+/** Frees the instance, NULL is ignored. */
+JSIF_CAPI void jsif_destroy(jsif_instance* instance);
+
+/** Allocates everything for the format and clears the state, parameters are kept. */
+JSIF_CAPI jsif_result jsif_prepare(jsif_instance* instance, double sample_rate, int32_t channels, int32_t max_block);
+
+/** Processes frames of channels planar buffers. */
+JSIF_CAPI jsif_result jsif_process_f32(jsif_instance* instance, const float* const* in, float* const* out,
+                                       int32_t channels, int32_t frames);
+JSIF_CAPI jsif_result jsif_process_f64(jsif_instance* instance, const double* const* in, double* const* out,
+                                       int32_t channels, int32_t frames);
+
+/** Sets a normalized parameter, values outside 0..1 are clamped. */
+JSIF_CAPI jsif_result jsif_set_param(jsif_instance* instance, jsif_param id, double value);
+
+/** The value last set, or the default. -1 for an unknown parameter or NULL instance. */
+JSIF_CAPI double jsif_get_param(const jsif_instance* instance, jsif_param id);
+
+/** Clears filter, resampler and latency state, the output is as after prepare. Parameters are kept. */
+JSIF_CAPI jsif_result jsif_reset(jsif_instance* instance);
+
+/** Latency in frames for the OS / Phase parameters last set, -1 for a NULL instance. */
+JSIF_CAPI int32_t jsif_get_latency(const jsif_instance* instance);
+
+#ifdef __cplusplus
+}
+#endif
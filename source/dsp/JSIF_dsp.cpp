@@ -0,0 +1,894 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+
+#include <cstring>
+
+namespace yg331 {
+	//------------------------------------------------------------------------
+	// JSIF_DSP
+	//------------------------------------------------------------------------
+	void JSIF_DSP::prepare(double newSampleRate, int32 newNumChannels, int32 maxSamplesPerBlock)
+	{
+		sampleRate  = newSampleRate;
+		numChannels = newNumChannels;
+
+		latency_q.assign(numChannels, DelayLine());
+		for (auto& loop : latency_q) loop.prepare(bLowFootprint ? latency_Fir_x8 : maxLatency);
+
+		bandSplit.assign(numChannels, Band_Split());
+		for (int32 channel = 0; channel < numChannels; channel++)
+			Band_Split_set(&bandSplit[channel], 240.0, 2400.0, sampleRate);
+
+		upSample_21.assign(numChannels, Flt());
+		upSample_41.assign(numChannels, Flt());
+		upSample_42.assign(numChannels, Flt());
+		upSample_81.assign(numChannels, Flt());
+		upSample_82.assign(numChannels, Flt());
+		upSample_83.assign(numChannels, Flt());
+
+		dnSample_21.assign(numChannels, Flt());
+		dnSample_41.assign(numChannels, Flt());
+		dnSample_42.assign(numChannels, Flt());
+		dnSample_81.assign(numChannels, Flt());
+		dnSample_82.assign(numChannels, Flt());
+		dnSample_83.assign(numChannels, Flt());
+
+		const FirTables& tables = firTables();
+
+		for (int channel = 0; channel < numChannels; channel++) 
+		{
+			upSample_21[channel].coef = tables.up_21;
+			upSample_41[channel].coef = tables.up_41;
+			upSample_42[channel].coef = tables.up_42;
+			upSample_81[channel].coef = tables.up_81;
+			upSample_82[channel].coef = tables.up_82;
+			upSample_83[channel].coef = tables.up_83;
+
+			dnSample_21[channel].coef = tables.dn_21;
+			dnSample_41[channel].coef = tables.dn_41;
+			dnSample_42[channel].coef = tables.dn_42;
+			dnSample_81[channel].coef = tables.dn_81;
+			dnSample_82[channel].coef = tables.dn_82;
+			dnSample_83[channel].coef = tables.dn_83;
+
+#define FLT_SET(filter, tap_size) \
+filter[channel].TAP_SIZE = tap_size; \
+filter[channel].TAP_HALF = tap_size / 2; \
+filter[channel].TAP_HALF_HALF = filter[channel].TAP_HALF / 2; \
+filter[channel].TAP_CONDITION = tap_size % 4; \
+if (filter[channel].TAP_CONDITION == 1) \
+{ \
+	/* 0 == coef[0], coef[2], coef[4], coef[6], ... */ \
+	filter[channel].START = 1; \
+} \
+else if (filter[channel].TAP_CONDITION == 3) \
+{ \
+	/* 0 == coef[1], coef[3], coef[5], coef[7], ... */ \
+	filter[channel].START = 0; \
+} \
+
+			FLT_SET(upSample_21, upTap_21);
+			FLT_SET(upSample_41, upTap_41);
+			FLT_SET(upSample_42, upTap_42);
+			FLT_SET(upSample_81, upTap_81);
+			FLT_SET(upSample_82, upTap_82);
+			FLT_SET(upSample_83, upTap_83);
+
+			FLT_SET(dnSample_21, dnTap_21);
+			FLT_SET(dnSample_41, dnTap_41);
+			FLT_SET(dnSample_42, dnTap_42);
+			FLT_SET(dnSample_81, dnTap_81);
+			FLT_SET(dnSample_82, dnTap_82);
+			FLT_SET(dnSample_83, dnTap_83);
+		}
+
+		// fresh resamplers, with low footprint only the current mode's ones
+		for (auto* resamplers : { &upSample_2x_Lin, &upSample_4x_Lin, &upSample_8x_Lin,
+		                          &dnSample_2x_Lin, &dnSample_4x_Lin, &dnSample_8x_Lin })
+		{
+			resamplers->clear();
+			resamplers->resize(numChannels);
+		}
+		if (!bLowFootprint)
+		{
+			prepareResamplers(2);
+			prepareResamplers(4);
+			prepareResamplers(8);
+		}
+
+		VuInput.setChannel(numChannels);
+		VuInput.setType(LevelEnvelopeFollower::Peak);
+		VuInput.setDecay(3.0);
+		VuInput.prepare(sampleRate);
+
+		VuOutput.setChannel(numChannels);
+		VuOutput.setType(LevelEnvelopeFollower::Peak);
+		VuOutput.setDecay(3.0);
+		VuOutput.prepare(sampleRate);
+
+		maxBlockSize = std::max(maxSamplesPerBlock, 1);
+		buff.resize(numChannels);
+		buff_head.resize(numChannels);
+		for (int channel = 0; channel < numChannels; channel++)
+		{
+			buff[channel].assign(maxBlockSize, 0.0);
+			buff_head[channel] = buff[channel].data();
+		}
+		for (auto* pointers : { &split32.in, &split32.out })
+			pointers->assign(numChannels, nullptr);
+		for (auto* pointers : { &split64.in, &split64.out })
+			pointers->assign(numChannels, nullptr);
+
+		Meter = 0.0;
+
+		if (channelWorker && numChannels < 2)
+			channelWorker.reset();
+	}
+
+	//------------------------------------------------------------------------
+	void JSIF_DSP::reset()
+	{
+		for (auto& loop : latency_q) loop.clear();
+
+		for (int32 channel = 0; channel < numChannels; channel++)
+		{
+			for (auto* filter : { &upSample_21[channel], &upSample_41[channel], &upSample_42[channel],
+			                      &upSample_81[channel], &upSample_82[channel], &upSample_83[channel],
+			                      &dnSample_21[channel], &dnSample_41[channel], &dnSample_42[channel],
+			                      &dnSample_81[channel], &dnSample_82[channel], &dnSample_83[channel] })
+				memset(filter->buff, 0, sizeof(filter->buff));
+
+			for (auto* resampler : { &upSample_2x_Lin[channel], &upSample_4x_Lin[channel], &upSample_8x_Lin[channel],
+			                         &dnSample_2x_Lin[channel], &dnSample_4x_Lin[channel], &dnSample_8x_Lin[channel] })
+				if (*resampler) (*resampler)->clear();
+
+			bandSplit[channel].LP.R = bandSplit[channel].LP.I = 0.0;
+			bandSplit[channel].HP.R = bandSplit[channel].HP.I = 0.0;
+		}
+
+		VuInput.prepare(sampleRate);
+		VuOutput.prepare(sampleRate);
+		Meter = 0.0;
+	}
+
+	//------------------------------------------------------------------------
+	JSIF_DSP::FirTables::FirTables()
+	{
+		// Strictly HALF_BAND
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, upTap_21, 100.0, up_21); //
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, upTap_41, 100.0, up_41); //
+		Kaiser::calcFilter(192000.0, 0.0, 48000.0, upTap_42, 100.0, up_42);
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, upTap_81, 100.0, up_81); //
+		Kaiser::calcFilter(192000.0, 0.0, 48000.0, upTap_82, 100.0, up_82);
+		Kaiser::calcFilter(384000.0, 0.0, 96000.0, upTap_83, 100.0, up_83);
+
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, dnTap_21, 100.0, dn_21); //
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, dnTap_41, 100.0, dn_41); //
+		Kaiser::calcFilter(192000.0, 0.0, 48000.0, dnTap_42, 100.0, dn_42);
+		Kaiser::calcFilter(96000.0,  0.0, 24000.0, dnTap_81, 100.0, dn_81); //
+		Kaiser::calcFilter(192000.0, 0.0, 48000.0, dnTap_82, 100.0, dn_82);
+		Kaiser::calcFilter(384000.0, 0.0, 96000.0, dnTap_83, 100.0, dn_83);
+
+		for (int i = 0; i < upTap_21; i++) up_21[i] *= 2.0;
+		for (int i = 0; i < upTap_41; i++) up_41[i] *= 2.0;
+		for (int i = 0; i < upTap_42; i++) up_42[i] *= 2.0;
+		for (int i = 0; i < upTap_81; i++) up_81[i] *= 2.0;
+		for (int i = 0; i < upTap_82; i++) up_82[i] *= 2.0;
+		for (int i = 0; i < upTap_83; i++) up_83[i] *= 2.0;
+	}
+
+	const JSIF_DSP::FirTables& JSIF_DSP::firTables()
+	{
+		static const FirTables tables;
+		return tables;
+	}
+
+	//------------------------------------------------------------------------
+	void JSIF_DSP::prepareResamplers(int32 oversampling)
+	{
+		std::vector<Resampler>* up = &upSample_2x_Lin;
+		std::vector<Resampler>* dn = &dnSample_2x_Lin;
+		double transition = 2.0;
+		if      (oversampling == 4) { up = &upSample_4x_Lin; dn = &dnSample_4x_Lin; transition = 2.1; }
+		else if (oversampling == 8) { up = &upSample_8x_Lin; dn = &dnSample_8x_Lin; transition = 2.2; }
+		else if (oversampling != 2) return;
+
+		for (int32 channel = 0; channel < numChannels; channel++)
+		{
+			if (!(*up)[channel]) (*up)[channel].reset(new r8b::CDSPResampler24(1.0, oversampling, 1 * oversampling, transition));
+			if (!(*dn)[channel]) (*dn)[channel].reset(new r8b::CDSPResampler24(oversampling, 1.0, 1 * oversampling, transition));
+		}
+	}
+
+	void JSIF_DSP::prepareMode(int32 latency, int32 oversampling)
+	{
+		if (!bLowFootprint)
+			return;
+		// a resampler created now is as clean as one that was never used, output stays the same
+		for (auto& loop : latency_q) loop.reserve(latency);
+		if (fParamPhase && oversampling > 1)
+			prepareResamplers(oversampling);
+	}
+
+	//------------------------------------------------------------------------
+	JSIF_DSP::MemoryReport JSIF_DSP::getMemoryReport() const
+	{
+		MemoryReport report;
+		report.object = sizeof(JSIF_DSP);
+
+		for (auto* filters : { &upSample_21, &upSample_41, &upSample_42, &upSample_81, &upSample_82, &upSample_83,
+		                       &dnSample_21, &dnSample_41, &dnSample_42, &dnSample_81, &dnSample_82, &dnSample_83 })
+			report.filters += filters->capacity() * sizeof(Flt);
+
+		for (auto* resamplers : { &upSample_2x_Lin, &upSample_4x_Lin, &upSample_8x_Lin,
+		                          &dnSample_2x_Lin, &dnSample_4x_Lin, &dnSample_8x_Lin })
+		{
+			report.other += resamplers->capacity() * sizeof(Resampler);
+			for (auto& resampler : *resamplers)
+				if (resampler)
+				{
+					report.resamplers += sizeof(r8b::CDSPResampler24);
+					report.resamplerCount++;
+				}
+		}
+
+		report.latency += latency_q.capacity() * sizeof(DelayLine);
+		for (auto& loop : latency_q)
+			report.latency += loop.bytes() - sizeof(DelayLine);
+
+		report.buffers += buff.capacity() * sizeof(std::vector<double>);
+		for (auto& channel : buff)
+			report.buffers += channel.capacity() * sizeof(double);
+
+		// the followers are members, only their heap is added
+		report.meters = VuInput.bytes() + VuOutput.bytes() - 2 * sizeof(LevelEnvelopeFollower);
+
+		report.other += bandSplit.capacity() * sizeof(Band_Split) + buff_head.capacity() * sizeof(double*);
+		report.other += (split32.in.capacity() + split32.out.capacity()) * sizeof(float*)
+		              + (split64.in.capacity() + split64.out.capacity()) * sizeof(double*);
+		if (channelWorker)
+			report.other += sizeof(ChannelWorker);
+
+		report.shared = sizeof(FirTables);
+		return report;
+	}
+
+	//------------------------------------------------------------------------
+	void JSIF_DSP::setChannelThreads(bool state)
+	{
+		if (state && numChannels > 1)
+		{
+			if (!channelWorker)
+				channelWorker = std::make_unique<ChannelWorker>();
+		}
+		else
+			channelWorker.reset();
+	}
+
+	//------------------------------------------------------------------------
+	overSample JSIF_DSP::overSampleFromNormalized(double value)
+	{
+		// same mapping as Steinberg::FromNormalized(value, overSample_num)
+		double step = static_cast<double>(overSample_num);
+		return static_cast<overSample>(static_cast<int32>(std::min(step, value * (step + 1))));
+	}
+
+	double JSIF_DSP::overSampleToNormalized(overSample os)
+	{
+		return static_cast<double>(os) / static_cast<double>(overSample_num);
+	}
+
+	void JSIF_DSP::setParam(Param id, double value)
+	{
+		switch (id) {
+		case kInput:  fInput      = value;          break;
+		case kEffect: fEffect     = value;          break;
+		case kCurve:  fCurve      = value;          break;
+		case kClip:   bClip       = (value > 0.5);  break;
+		case kOutput: fOutput     = value;          break;
+		case kOS:     fParamOS    = overSampleFromNormalized(value); break;
+		case kSplit:  bSplit      = (value > 0.5);  break;
+		case kPhase:  fParamPhase = (value > 0.5);  break;
+		case kIn:     bIn         = (value > 0.5);  break;
+		case kBypass: bBypass     = (value > 0.5);  break;
+		default: break;
+		}
+	}
+
+	double JSIF_DSP::getParam(Param id) const
+	{
+		switch (id) {
+		case kInput:  return fInput;
+		case kEffect: return fEffect;
+		case kCurve:  return fCurve;
+		case kClip:   return bClip ? 1.0 : 0.0;
+		case kOutput: return fOutput;
+		case kOS:     return overSampleToNormalized(fParamOS);
+		case kSplit:  return bSplit ? 1.0 : 0.0;
+		case kPhase:  return fParamPhase ? 1.0 : 0.0;
+		case kIn:     return bIn ? 1.0 : 0.0;
+		case kBypass: return bBypass ? 1.0 : 0.0;
+		default: break;
+		}
+		return 0.0;
+	}
+
+	//------------------------------------------------------------------------
+	int32_t JSIF_DSP::latencyFor(overSample os, bool linearPhase)
+	{
+		if (linearPhase) {
+			if      (os == overSample_1x) return 0;
+			else if (os == overSample_2x) return latency_r8b_x2;
+			else if (os == overSample_4x) return latency_r8b_x4;
+			else                          return latency_r8b_x8;
+		}
+		else {
+			if      (os == overSample_1x) return 0;
+			else if (os == overSample_2x) return latency_Fir_x2;
+			else if (os == overSample_4x) return latency_Fir_x4;
+			else                          return latency_Fir_x8;
+		}
+	}
+
+	int32_t JSIF_DSP::getSettleSamples() const
+	{
+		// FIR and r8brain memory spans twice their delay, the FIR buffers hold maxFltBuff samples at most
+		int32 settle = 2 * getLatencySamples() + maxFltBuff;
+		if (!bSplit || !bIn)
+			return settle;
+
+		// the band split integrators decay by |1 - 2C| per oversampled sample
+		int32 oversampling = fParamOS == overSample_2x ? 2 : fParamOS == overSample_4x ? 4 : fParamOS == overSample_8x ? 8 : 1;
+		double Fs = sampleRate * oversampling;
+		double slowest = 0.0;
+		for (double Fc : { 240.0, 2400.0 })
+		{
+			double C = 0.5 * tan(M_PI * ((Fc / Fs) - 0.25)) + 0.5;
+			slowest = std::max(slowest, std::abs(1.0 - 2.0 * C));
+		}
+		if (slowest <= 0.0 || slowest >= 1.0)
+			return settle;
+		double decay = std::ceil(std::log(1e-12) / std::log(slowest));
+		return settle + static_cast<int32>(std::ceil(decay / oversampling));
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void JSIF_DSP::process(SampleType** inputs, SampleType** outputs, int32 numChannels, int32 sampleFrames)
+	{
+		numChannels = std::min(numChannels, this->numChannels);
+		if (numChannels <= 0 || sampleFrames <= 0)
+			return;
+
+		JSIF_PROFILE_BLOCK(profiler, sampleFrames, sampleRate);
+
+		if (bBypass)
+		{
+			latencyBypass(inputs, outputs, numChannels, sampleFrames);
+			return;
+		}
+
+		// blocks longer than prepared are split, the meter covers the whole block
+		double t = 0.0;
+		auto& split = splitPointers(inputs[0]);
+		for (int32 offset = 0; offset < sampleFrames; offset += maxBlockSize)
+		{
+			int32 frames = std::min(maxBlockSize, sampleFrames - offset);
+			if (offset == 0 && frames == sampleFrames)
+			{
+				t += processAudio(inputs, outputs, numChannels, frames);
+				break;
+			}
+			for (int32 channel = 0; channel < numChannels; channel++)
+			{
+				split.in [channel] = inputs [channel] + offset;
+				split.out[channel] = outputs[channel] + offset;
+			}
+			t += processAudio(split.in.data(), split.out.data(), numChannels, frames);
+		}
+		Meter = 80.0 - t;
+	}
+
+	template void JSIF_DSP::process<float> (float**  inputs, float**  outputs, int32 numChannels, int32 sampleFrames);
+	template void JSIF_DSP::process<double>(double** inputs, double** outputs, int32 numChannels, int32 sampleFrames);
+
+	//------------------------------------------------------------------------
+	JSIF_DSP::Sample64 JSIF_DSP::process_inflator(Sample64 inputSample)
+	{
+		// Sample64 drySample = inputSample;
+		Sample64 sign;
+
+		if (inputSample > 0.0) sign =  1.0;
+		else                   sign = -1.0;
+
+		Sample64 s1 = fabs(inputSample);
+		Sample64 s2 = s1 * s1;
+		Sample64 s3 = s2 * s1;
+		Sample64 s4 = s2 * s2;
+
+		if      (s1 >= 2.0) inputSample = 0.0;
+		else if (s1 >  1.0) inputSample = (2.0 * s1) - s2;
+		else                inputSample = (curveA * s1) +
+		                                  (curveB * s2) +
+		                                  (curveC * s3) -
+		                                  (curveD * (s2 - (2.0 * s3) + s4));
+		inputSample *= sign;
+
+		return inputSample;
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void JSIF_DSP::latencyBypass(
+		SampleType** inputs,
+		SampleType** outputs,
+		int32 numChannels,
+		int32 sampleFrames
+	)
+	{
+		int32 latency = 0;
+		if (!fParamPhase) {
+			if      (fParamOS == overSample_2x) latency = latency_Fir_x2;
+			else if (fParamOS == overSample_4x) latency = latency_Fir_x4;
+			else if (fParamOS == overSample_8x) latency = latency_Fir_x8;
+		}
+		else {
+			if      (fParamOS == overSample_2x) latency = latency_r8b_x2;
+			else if (fParamOS == overSample_4x) latency = latency_r8b_x4;
+			else if (fParamOS == overSample_8x) latency = latency_r8b_x8;
+		}
+
+		prepareMode(latency, 1);
+
+		for (int32 channel = 0; channel < numChannels; channel++)
+		{
+			SampleType* ptrIn  = (SampleType*) inputs[channel];
+			SampleType* ptrOut = (SampleType*)outputs[channel];
+			int32 samples = sampleFrames;
+			
+			if (fParamOS == overSample_1x) {
+				memcpy(ptrOut, ptrIn, sizeof(SampleType) * sampleFrames);
+				continue;
+			}
+
+			if (latency != latency_q[channel].size())
+				latency_q[channel].resize(latency);
+
+			while (--samples >= 0)
+			{
+				double inin = *ptrIn;
+				*ptrOut = (SampleType)latency_q[channel].process(inin);
+
+				ptrIn++;
+				ptrOut++;
+			}
+		}
+		if (!bMetering)
+			return;
+
+		JSIF_PROFILE_TICK(meterStart);
+		VuInput.update(inputs, numChannels, sampleFrames);
+		VuOutput.update(outputs, numChannels, sampleFrames);
+		JSIF_PROFILE_TICK(meterEnd);
+		JSIF_PROFILE_SPAN(profiler, kMetering, meterStart, meterEnd);
+
+		return;
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	double JSIF_DSP::processAudio(
+		SampleType** inputs, 
+		SampleType** outputs, 
+		int32 numChannels,
+		int32 sampleFrames
+	)
+	{
+		Sample64 In_db  = expf(logf(10.f) * (24.0 * fInput  - 12.0) / 20.f);
+		Sample64 Out_db = expf(logf(10.f) * (12.0 * fOutput - 12.0) / 20.f);
+
+		curvepct = fCurve - 0.5;
+		curveA =        1.5 + curvepct; 
+		curveB = -(curvepct + curvepct); 
+		curveC =   curvepct - 0.5; 
+		curveD = 0.0625 - curvepct * 0.25 + (curvepct * curvepct) * 0.25;	
+
+		int32 latency = 0;
+		if (!fParamPhase) {
+			if      (fParamOS == overSample_2x) latency = latency_Fir_x2;
+			else if (fParamOS == overSample_4x) latency = latency_Fir_x4;
+			else if (fParamOS == overSample_8x) latency = latency_Fir_x8;
+		}
+		else {
+			if      (fParamOS == overSample_2x) latency = latency_r8b_x2;
+			else if (fParamOS == overSample_4x) latency = latency_r8b_x4;
+			else if (fParamOS == overSample_8x) latency = latency_r8b_x8;
+		}
+
+		int32 oversampling = 1;
+		if      (fParamOS == overSample_2x) oversampling = 2;
+		else if (fParamOS == overSample_4x) oversampling = 4;
+		else if (fParamOS == overSample_8x) oversampling = 8;
+
+		prepareMode(latency, oversampling);
+
+		double targetSampleRate = sampleRate * oversampling;
+		
+		for (int32 channel = 0; channel < numChannels; channel++)
+			if (bandSplit[channel].SR != targetSampleRate) 
+				Band_Split_set(&bandSplit[channel], 240.0, 2400.0, targetSampleRate);
+        
+		double t = 0.0;
+
+		if (channelWorker && numChannels > 1)
+		{
+			// channel state is disjoint, only the meter sum is shared
+			double t_worker = 0.0;
+			channelWorker->run([&] {
+				for (int32 channel = 1; channel < numChannels; channel++)
+					processChannel(inputs[channel], outputs[channel], channel, sampleFrames, In_db, Out_db, latency, oversampling, t_worker);
+			});
+			processChannel(inputs[0], outputs[0], 0, sampleFrames, In_db, Out_db, latency, oversampling, t);
+			channelWorker->wait();
+			t += t_worker;
+		}
+		else
+		{
+			for (int32 channel = 0; channel < numChannels; channel++)
+				processChannel(inputs[channel], outputs[channel], channel, sampleFrames, In_db, Out_db, latency, oversampling, t);
+		}
+
+		if (bMetering)
+		{
+			JSIF_PROFILE_TICK(meterStart);
+			VuInput.update(buff_head.data(), numChannels, sampleFrames);
+			VuOutput.update(outputs, numChannels, sampleFrames);
+			JSIF_PROFILE_TICK(meterEnd);
+			JSIF_PROFILE_SPAN(profiler, kMetering, meterStart, meterEnd);
+		}
+
+		return t;
+	}
+
+	template <typename SampleType>
+	void JSIF_DSP::processChannel(
+		SampleType* ptrIn,
+		SampleType* ptrOut,
+		int32 channel,
+		int32 sampleFrames,
+		Sample64 In_db,
+		Sample64 Out_db,
+		int32 latency,
+		int32 oversampling,
+		double& t
+	)
+	{
+        double up_x[8] = {0.0, };
+        double up_y[8] = {0.0, };
+
+		double* buff_in = buff[channel].data();
+			
+		if (latency != latency_q[channel].size())
+			latency_q[channel].resize(latency);
+
+		int32 samples = sampleFrames;
+
+		JSIF_PROFILE_STAGES(stages, profiler, channel, oversampling, fParamPhase);
+
+		while (--samples >= 0)
+		{
+			Sample64 inputSample = *ptrIn;
+
+			inputSample *= In_db;
+
+			if (bClip) {
+				if      (inputSample >  1.0) inputSample =  1.0;
+				else if (inputSample < -1.0) inputSample = -1.0;
+			}
+
+			if      (inputSample >  2.0) inputSample =  2.0;
+			else if (inputSample < -2.0) inputSample = -2.0;
+
+			Sample64 drySample = inputSample;
+
+			// Upsampling
+			JSIF_PROFILE_TICK(t0);
+			upsampleStage(inputSample, up_x, channel, oversampling);
+
+			// Processing
+			JSIF_PROFILE_TICK(t1);
+			shapeStage(up_x, up_y, channel, oversampling);
+
+			// Downsampling
+			JSIF_PROFILE_TICK(t2);
+			inputSample = downsampleStage(up_y, channel, oversampling);
+			JSIF_PROFILE_TICK(t3);
+
+			JSIF_PROFILE_SPAN(stages, kUpsample,   t0, t1);
+			JSIF_PROFILE_SPAN(stages, kShape,      t1, t2);
+			JSIF_PROFILE_SPAN(stages, kDownsample, t2, t3);
+
+			// Latency compensate
+			Sample64 delayed = latency_q[channel].process(drySample);
+			*buff_in = delayed;  buff_in++;
+                
+			inputSample = (delayed * (1.0 - fEffect)) + (inputSample * fEffect);
+                
+			t += std::abs(inputSample) - std::abs(delayed);
+			// Meter += 20.0 * (std::log10(std::abs(inputSample)) - std::log10(std::abs(delayed)));
+
+			inputSample *= Out_db;
+
+			*ptrOut = (SampleType)inputSample;
+
+			ptrIn++;
+			ptrOut++;
+		}
+	}
+
+	//------------------------------------------------------------------------
+	void JSIF_DSP::upsampleStage(Sample64 inputSample, Sample64* up_x, int32 channel, int32 oversampling)
+	{
+		if              (fParamOS == overSample_1x) up_x[0] = inputSample;
+		else {
+			if (!fParamPhase) {
+				if      (fParamOS == overSample_2x) Fir_x2_up(&inputSample, up_x, channel);
+				else if (fParamOS == overSample_4x) Fir_x4_up(&inputSample, up_x, channel);
+				else                                Fir_x8_up(&inputSample, up_x, channel);
+			}
+			else {
+				double* upSample_buff;
+				if      (fParamOS == overSample_2x) upSample_2x_Lin[channel]->process(&inputSample, 1, upSample_buff);
+				else if (fParamOS == overSample_4x) upSample_4x_Lin[channel]->process(&inputSample, 1, upSample_buff);
+				else                                upSample_8x_Lin[channel]->process(&inputSample, 1, upSample_buff);
+				memcpy(up_x, upSample_buff, sizeof(Sample64) * oversampling);
+			}
+		}
+	}
+
+	void JSIF_DSP::shapeStage(const Sample64* up_x, Sample64* up_y, int32 channel, int32 oversampling)
+	{
+		for (int k = 0; k < oversampling; k++) {
+			if (!bIn) {
+				up_y[k] = up_x[k];
+				continue;
+			}
+			Sample64 sampleOS = up_x[k];
+			if (bSplit) {
+				bandSplit[channel].LP.R =      bandSplit[channel].LP.I  + bandSplit[channel].LP.C * (sampleOS - bandSplit[channel].LP.I);
+				bandSplit[channel].LP.I =  2 * bandSplit[channel].LP.R  - bandSplit[channel].LP.I;
+
+				bandSplit[channel].HP.R = (1 - bandSplit[channel].HP.C) * bandSplit[channel].HP.I + bandSplit[channel].HP.C * sampleOS;
+				bandSplit[channel].HP.I =  2 * bandSplit[channel].HP.R  - bandSplit[channel].HP.I;
+
+				Sample64 inputSample_L = bandSplit[channel].LP.R;
+				Sample64 inputSample_H = sampleOS - bandSplit[channel].HP.R;
+				Sample64 inputSample_M = bandSplit[channel].HP.R - bandSplit[channel].LP.R;
+
+				up_y[k] = process_inflator(inputSample_L) +
+				          process_inflator(inputSample_M * bandSplit[channel].G) * bandSplit[channel].GR +
+				          process_inflator(inputSample_H);
+			}
+			else {
+				up_y[k] = process_inflator(sampleOS);
+				// up_y[k] = up_x[k];
+			}
+			if (bClip && up_y[k] >  1.0) up_y[k] =  1.0;
+			if (bClip && up_y[k] < -1.0) up_y[k] = -1.0;
+		}
+	}
+
+	JSIF_DSP::Sample64 JSIF_DSP::downsampleStage(Sample64* up_y, int32 channel, int32 oversampling)
+	{
+		Sample64 out;
+		if              (fParamOS == overSample_1x) out = up_y[0];
+		else {
+			if (!fParamPhase) {
+				if      (fParamOS == overSample_2x) Fir_x2_dn(up_y, &out, channel);
+				else if (fParamOS == overSample_4x) Fir_x4_dn(up_y, &out, channel);
+				else                                Fir_x8_dn(up_y, &out, channel);
+			}
+			else {
+				double* dnSample_buff;
+				if      (fParamOS == overSample_2x) dnSample_2x_Lin[channel]->process(up_y, oversampling, dnSample_buff);
+				else if (fParamOS == overSample_4x) dnSample_4x_Lin[channel]->process(up_y, oversampling, dnSample_buff);
+				else                                dnSample_8x_Lin[channel]->process(up_y, oversampling, dnSample_buff);
+				out = *dnSample_buff;
+			}
+		}
+		return out;
+	}
+
+	/// Fir Linear Oversamplers
+	void JSIF_DSP::HB_upsample(Flt* filter, Sample64* out)
+	{
+		// half-band
+		double acc = 0.0;
+		for (int coef = filter->START, buff = 0; coef < filter->TAP_HALF; coef += 2, buff++)
+		{
+			acc += filter->coef[coef] * (filter->buff[buff] + filter->buff[filter->TAP_HALF - buff - filter->START]);
+		}
+		
+		double acc_1 = 0.0;
+		double acc_2 = 0.0;
+		if (filter->TAP_CONDITION == 1)
+		{
+			acc_1 = filter->coef[filter->TAP_HALF] * filter->buff[filter->TAP_HALF_HALF];
+			acc_2 = acc;
+		}
+		else // if (filter->TAP_CONDITION == 3)
+		{
+			acc_1 = acc;
+			acc_2 = filter->coef[filter->TAP_HALF] *  filter->buff[filter->TAP_HALF_HALF];
+		}
+		
+		*(out  ) = acc_1;
+		*(out+1) = acc_2;
+	}
+	void JSIF_DSP::HB_dnsample(Flt* filter, Sample64* out)
+	{
+		// half-band
+		double acc = 0.0;
+		int TAP_SIZE_1 = filter->TAP_SIZE - 1;
+		for (int i = filter->START; i < filter->TAP_HALF; i+=2) // buffer + 2 is offset
+		{
+			acc += filter->coef[i] * (filter->buff[2 + i] + filter->buff[2 + TAP_SIZE_1 - i]);
+		}
+		acc += filter->coef[filter->TAP_HALF] * filter->buff[2 + filter->TAP_HALF];
+		*out = acc;
+	}
+	
+	// 1 in 2 out
+	void JSIF_DSP::Fir_x2_up(Sample64* in, Sample64* out, int32 channel) 
+	{
+		static constexpr size_t upTap_21_size = sizeof(double) * (upTap_21 - 1) / 2;
+		memmove(upSample_21[channel].buff + 1, upSample_21[channel].buff, upTap_21_size);
+		upSample_21[channel].buff[0] = *in;
+		HB_upsample(&upSample_21[channel], out);
+		
+		return;
+	}
+	// 1 in 4 out
+	void JSIF_DSP::Fir_x4_up(Sample64* in, Sample64* out, int32 channel)
+	{
+		Sample64 inter_41[2];
+		static constexpr size_t  upTap_41_size = sizeof(double) * (upTap_41 - 1) / 2;
+		memmove(upSample_41[channel].buff + 1, upSample_41[channel].buff, upTap_41_size);
+		upSample_41[channel].buff[0] = *in;
+		HB_upsample(&upSample_41[channel], &inter_41[0]);
+		
+		static constexpr size_t upTap_42_size = sizeof(double) * (upTap_42 - 1) / 2;
+		memmove(upSample_42[channel].buff + 1, upSample_42[channel].buff, upTap_42_size);
+		upSample_42[channel].buff[0] = inter_41[0];
+		HB_upsample(&upSample_42[channel], &out[0]);
+		
+		memmove(upSample_42[channel].buff + 1, upSample_42[channel].buff, upTap_42_size);
+		upSample_42[channel].buff[0] = inter_41[1];
+		HB_upsample(&upSample_42[channel], &out[2]);
+		
+		return;
+	}
+	// 1 in 8 out
+	void JSIF_DSP::Fir_x8_up(Sample64* in, Sample64* out, int32 channel)
+	{
+		Sample64 inter_81[2];
+		static constexpr size_t upTap_81_size = sizeof(double) * (upTap_81 - 1) / 2;
+		memmove(upSample_81[channel].buff + 1, upSample_81[channel].buff, upTap_81_size);
+		upSample_81[channel].buff[0] = *in;
+		HB_upsample(&upSample_81[channel], &inter_81[0]);
+		
+		Sample64 inter_82[4];
+		static constexpr size_t upTap_82_size = sizeof(double) * (upTap_82 - 1) / 2;
+		memmove(upSample_82[channel].buff + 1, upSample_82[channel].buff, upTap_82_size);
+		upSample_82[channel].buff[0] = inter_81[0];
+		HB_upsample(&upSample_82[channel], &inter_82[0]);
+		
+		memmove(upSample_82[channel].buff + 1, upSample_82[channel].buff, upTap_82_size);
+		upSample_82[channel].buff[0] = inter_81[1];
+		HB_upsample(&upSample_82[channel], &inter_82[2]);
+		
+		static constexpr size_t upTap_83_size = sizeof(double) * (upTap_83 - 1) / 2;
+		memmove(upSample_83[channel].buff + 1, upSample_83[channel].buff, upTap_83_size);
+		upSample_83[channel].buff[0] = inter_82[0];
+		HB_upsample(&upSample_83[channel], &out[0]);
+		
+		memmove(upSample_83[channel].buff + 1, upSample_83[channel].buff, upTap_83_size);
+		upSample_83[channel].buff[0] = inter_82[1];
+		HB_upsample(&upSample_83[channel], &out[2]);
+		
+		memmove(upSample_83[channel].buff + 1, upSample_83[channel].buff, upTap_83_size);
+		upSample_83[channel].buff[0] = inter_82[2];
+		HB_upsample(&upSample_83[channel], &out[4]);
+		
+		memmove(upSample_83[channel].buff + 1, upSample_83[channel].buff, upTap_83_size);
+		upSample_83[channel].buff[0] = inter_82[3];
+		HB_upsample(&upSample_83[channel], &out[6]);
+		
+		return;
+	}
+	
+	
+	// 2 in 1 out
+	void JSIF_DSP::Fir_x2_dn(Sample64* in, Sample64* out, int32 channel) 
+	{
+		static constexpr size_t dnTap_21_size = sizeof(double) * (dnTap_21 - 2);
+		memmove(dnSample_21[channel].buff + 3, dnSample_21[channel].buff + 1, dnTap_21_size);
+		dnSample_21[channel].buff[2] = in[0];
+		dnSample_21[channel].buff[1] = in[1];
+		HB_dnsample(&dnSample_21[channel], out);
+		
+		return;
+	}
+	// 4 in 1 out
+	void JSIF_DSP::Fir_x4_dn(Sample64* in, Sample64* out, int32 channel)
+	{
+		Sample64 inter_42[2];
+		static constexpr size_t dnTap_42_size = sizeof(double) * (dnTap_42 - 2);
+		memmove(dnSample_42[channel].buff + 3, dnSample_42[channel].buff + 1, dnTap_42_size);
+		dnSample_42[channel].buff[2] = in[0];
+		dnSample_42[channel].buff[1] = in[1];
+		HB_dnsample(&dnSample_42[channel], &inter_42[0]);
+		
+		memmove(dnSample_42[channel].buff + 3, dnSample_42[channel].buff + 1, dnTap_42_size);
+		dnSample_42[channel].buff[2] = in[2];
+		dnSample_42[channel].buff[1] = in[3];
+		HB_dnsample(&dnSample_42[channel], &inter_42[1]);
+		
+		const size_t dnTap_41_size = sizeof(double) * (dnTap_41-2);
+		memmove(dnSample_41[channel].buff + 3, dnSample_41[channel].buff + 1, dnTap_41_size);
+		dnSample_41[channel].buff[2] = inter_42[0];
+		dnSample_41[channel].buff[1] = inter_42[1];
+		HB_dnsample(&dnSample_41[channel], out);
+		
+		return;
+	}
+	// 8 in 1 out
+	void JSIF_DSP::Fir_x8_dn(Sample64* in, Sample64* out, int32 channel) 
+	{
+		Sample64 inter_83[4];
+		static constexpr size_t dnTap_83_size = sizeof(double) * (dnTap_83-2);
+		memmove(dnSample_83[channel].buff + 3, dnSample_83[channel].buff + 1, dnTap_83_size);
+		dnSample_83[channel].buff[2] = in[0];
+		dnSample_83[channel].buff[1] = in[1];
+		HB_dnsample(&dnSample_83[channel], &inter_83[0]);
+		
+		memmove(dnSample_83[channel].buff + 3, dnSample_83[channel].buff + 1, dnTap_83_size);
+		dnSample_83[channel].buff[2] = in[2];
+		dnSample_83[channel].buff[1] = in[3];
+		HB_dnsample(&dnSample_83[channel], &inter_83[1]);
+		
+		memmove(dnSample_83[channel].buff + 3, dnSample_83[channel].buff + 1, dnTap_83_size);
+		dnSample_83[channel].buff[2] = in[4];
+		dnSample_83[channel].buff[1] = in[5];
+		HB_dnsample(&dnSample_83[channel], &inter_83[2]);
+		
+		memmove(dnSample_83[channel].buff + 3, dnSample_83[channel].buff + 1, dnTap_83_size);
+		dnSample_83[channel].buff[2] = in[6];
+		dnSample_83[channel].buff[1] = in[7];
+		HB_dnsample(&dnSample_83[channel], &inter_83[3]);
+		
+		Sample64 inter_82[2];
+		static constexpr size_t dnTap_82_size = sizeof(double) * (dnTap_82-2);
+		memmove(dnSample_82[channel].buff + 3, dnSample_82[channel].buff + 1, dnTap_82_size);
+		dnSample_82[channel].buff[2] = inter_83[0];
+		dnSample_82[channel].buff[1] = inter_83[1];
+		HB_dnsample(&dnSample_82[channel], &inter_82[0]);
+		
+		memmove(dnSample_82[channel].buff + 3, dnSample_82[channel].buff + 1, dnTap_82_size);
+		dnSample_82[channel].buff[2] = inter_83[2];
+		dnSample_82[channel].buff[1] = inter_83[3];
+		HB_dnsample(&dnSample_82[channel], &inter_82[1]);
+		
+		static constexpr size_t dnTap_81_size = sizeof(double) * (dnTap_81-2);
+		memmove(dnSample_81[channel].buff + 3, dnSample_81[channel].buff + 1, dnTap_81_size);
+		dnSample_81[channel].buff[2] = inter_82[0];
+		dnSample_81[channel].buff[1] = inter_82[1];
+		HB_dnsample(&dnSample_81[channel], out);
+		
+		return;
+	}
+
+} // namespace yg331
@@ -0,0 +1,378 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "JSIF_dsp_types.h"
+#include "JSIF_filters.h"
+#include "JSIF_profiler.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <CDSPResampler.h>
+
+namespace yg331 {
+
+// Runs one job at a time on its own thread, used to spread channels
+// across cores when rendering offline.
+class ChannelWorker
+{
+public:
+	ChannelWorker() : thread([this] { loop(); }) {}
+
+	~ChannelWorker()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wakeUp.notify_one();
+		thread.join();
+	}
+
+	void run(std::function<void()> newJob)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = std::move(newJob);
+			pending = true;
+		}
+		wakeUp.notify_one();
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return !pending; });
+	}
+
+private:
+	void loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			wakeUp.wait(lock, [this] { return pending || quit; });
+			if (quit) return;
+			lock.unlock();
+			job();
+			lock.lock();
+			pending = false;
+			finished.notify_one();
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable finished;
+	std::function<void()> job;
+	bool pending = false;
+	bool quit = false;
+	std::thread thread;
+};
+
+//------------------------------------------------------------------------
+//  JSIF_DSP
+//------------------------------------------------------------------------
+// The complete Inflator signal path without any host dependency:
+// input gain, clip, oversampling (half-band FIR or r8brain linear phase),
+// optional 3-band split, the inflator curve, dry/wet with latency
+// compensation and output gain. JSIF_Processor drives it from process(),
+// tools can drive it directly.
+//
+// Parameters use the same normalized ranges as the plug-in parameters.
+// Call prepare() before processing, setters may be called between blocks.
+class JSIF_DSP
+{
+public:
+	enum Param {
+		kInput = 0,  // 0..1 -> -12..+12 dB
+		kEffect,     // 0..1 dry/wet
+		kCurve,      // 0..1 -> -50..+50 %
+		kClip,       // > 0.5 on
+		kOutput,     // 0..1 -> -12..0 dB
+		kOS,         // 0..1 -> x1, x2, x4, x8
+		kSplit,      // > 0.5 on
+		kPhase,      // > 0.5 linear phase (r8brain)
+		kIn,         // > 0.5 effect in
+		kBypass,     // > 0.5 bypassed, latency is kept
+		kNumParams
+	};
+
+	JSIF_DSP() = default;
+	~JSIF_DSP() = default;
+
+	JSIF_DSP(const JSIF_DSP&) = delete;
+	JSIF_DSP& operator=(const JSIF_DSP&) = delete;
+
+	/** Allocates and initializes everything for the given format. Not realtime safe.
+	 *  maxSamplesPerBlock below 1 is taken as 1. */
+	void prepare(double sampleRate, int32_t numChannels, int32_t maxSamplesPerBlock);
+
+	/** Clears all filter, resampler, latency and meter state, keeps parameters.
+	 *  The output after reset() is the same as after prepare() with the same format,
+	 *  without allocating or constructing anything: the way to reuse an instance for the next file. */
+	void reset();
+
+	/** Processes one block, in and out may alias. numChannels <= prepared channels,
+	 *  blocks longer than maxSamplesPerBlock are processed in pieces. */
+	template <typename SampleType>
+	void process(SampleType** inputs, SampleType** outputs, int32_t numChannels, int32_t sampleFrames);
+
+	//--- parameters ---------------------------------------------------------
+	void   setParam(Param id, double normalizedValue);
+	double getParam(Param id) const;
+
+	void setInput (double value) { fInput  = value; }
+	void setEffect(double value) { fEffect = value; }
+	void setCurve (double value) { fCurve  = value; }
+	void setOutput(double value) { fOutput = value; }
+	void setClip  (bool state)   { bClip   = state; }
+	void setSplit (bool state)   { bSplit  = state; }
+	void setIn    (bool state)   { bIn     = state; }
+	void setBypass(bool state)   { bBypass = state; }
+	void setOverSample (overSample os) { fParamOS = os; }
+	void setLinearPhase(bool state)    { fParamPhase = state; }
+
+	double     getInput()       const { return fInput; }
+	double     getEffect()      const { return fEffect; }
+	double     getCurve()       const { return fCurve; }
+	double     getOutput()      const { return fOutput; }
+	bool       getClip()        const { return bClip; }
+	bool       getSplit()       const { return bSplit; }
+	bool       getIn()          const { return bIn; }
+	bool       getBypass()      const { return bBypass; }
+	overSample getOverSample()  const { return fParamOS; }
+	bool       getLinearPhase() const { return fParamPhase; }
+
+	static overSample overSampleFromNormalized(double value);
+	static double     overSampleToNormalized(overSample os);
+
+	/** Latency of the current OS/Phase setting in samples. */
+	int32_t getLatencySamples() const { return latencyFor(fParamOS, fParamPhase); }
+	static int32_t latencyFor(overSample os, bool linearPhase);
+
+	/** Input samples after which the output of the current OS/Phase/Split setting no longer
+	 *  depends on what came before (filter, resampler and latency memory, band split decay
+	 *  to 1e-12): the pre-roll a fresh instance needs to continue a stream in the middle. */
+	int32_t getSettleSamples() const;
+
+	//--- execution profile --------------------------------------------------
+	/** Meters cost two log10 per sample and channel, offline renders switch them off. */
+	void setMetering(bool state) { bMetering = state; }
+	bool getMetering() const { return bMetering; }
+
+	/** Processes channels after the first one on a worker thread. Not realtime safe. */
+	void setChannelThreads(bool state);
+	bool getChannelThreads() const { return channelWorker != nullptr; }
+
+	/** Creates r8brain resamplers and the long latency ring only when a mode needs them.
+	 *  Output is unchanged, but switching to a new linear phase mode allocates in process().
+	 *  Takes effect on the next prepare(). */
+	void setLowFootprint(bool state) { bLowFootprint = state; }
+	bool getLowFootprint() const { return bLowFootprint; }
+
+	//--- memory -------------------------------------------------------------
+	/** Bytes held by one instance per subsystem. r8brain allocates its filters and
+	 *  buffers internally, resamplers only counts the objects it can see. */
+	struct MemoryReport
+	{
+		size_t  object     = 0;  // sizeof(JSIF_DSP)
+		size_t  filters    = 0;  // half-band FIR state, 12 Flt per channel
+		size_t  resamplers = 0;  // r8b::CDSPResampler24 objects
+		int32_t resamplerCount = 0;
+		size_t  latency    = 0;  // latency_q rings
+		size_t  buffers    = 0;  // dry signal block for the input meter
+		size_t  meters     = 0;  // envelope followers
+		size_t  other      = 0;  // band split, pointer tables
+		size_t  shared     = 0;  // FIR coefficient tables, once per process, not in total()
+
+		size_t total() const { return object + filters + resamplers + latency + buffers + meters + other; }
+	};
+	MemoryReport getMemoryReport() const;
+
+	//--- meters, valid after process() with metering on -------------------
+	double getInputEnv (int32_t channel) { return VuInput.getEnv(channel); }
+	double getOutputEnv(int32_t channel) { return VuOutput.getEnv(channel); }
+	/** Sum of |wet| - |dry| of the last block, the plug-in's effect meter source. */
+	double getMeter() const { return Meter; }
+
+	double  getSampleRate()  const { return sampleRate; }
+	int32_t getNumChannels() const { return numChannels; }
+
+#ifdef JSIF_ENABLE_PROFILING
+	/** Stage and block timing, the plug-in adds its own stages around process(). */
+	JSIF_Profiler& getProfiler() { return profiler; }
+#endif
+
+	static constexpr int32_t maxLatency = 3465;
+
+protected:
+	using Sample64 = double;
+	using int32 = int32_t;
+
+	void HB_upsample(Flt* filter, Sample64* out);
+	void HB_dnsample(Flt* filter, Sample64* out);
+
+	template <typename SampleType>
+	double processAudio(SampleType** inputs, SampleType** outputs, int32 numChannels, int32 sampleFrames);
+	template <typename SampleType>
+	void processChannel(SampleType* ptrIn, SampleType* ptrOut, int32 channel, int32 sampleFrames,
+	                    Sample64 In_db, Sample64 Out_db, int32 latency, int32 oversampling, double& t);
+	template <typename SampleType>
+	void latencyBypass(SampleType** inputs, SampleType** outputs, int32 numChannels, int32 sampleFrames);
+
+	// Per sample stages of processChannel, up_x/up_y hold `oversampling` samples
+	void     upsampleStage  (Sample64 inputSample, Sample64* up_x, int32 channel, int32 oversampling);
+	void     shapeStage     (const Sample64* up_x, Sample64* up_y, int32 channel, int32 oversampling);
+	Sample64 downsampleStage(Sample64* up_y, int32 channel, int32 oversampling);
+
+	Sample64 process_inflator(Sample64 inputSample);
+
+	/** Creates the missing linear phase resamplers for 2, 4 or 8 times oversampling. */
+	void prepareResamplers(int32 oversampling);
+	/** Low footprint: grows the latency rings and creates the resamplers the current mode needs. */
+	void prepareMode(int32 latency, int32 oversampling);
+
+	inline void Band_Split_set(Band_Split* filter, double Fc_L, double Fc_H, double Fs) {
+		(*filter).SR = Fs;
+		(*filter).LP.C = 0.5 * tan(M_PI * ((Fc_L / Fs) - 0.25)) + 0.5;
+		(*filter).LP.R = 0.0;
+		(*filter).LP.I = 0.0;
+		(*filter).HP.C = 0.5 * tan(M_PI * ((Fc_H / Fs) - 0.25)) + 0.5;
+		(*filter).HP.R = 0.0;
+		(*filter).HP.I = 0.0;
+		(*filter).G = (*filter).HP.C * (1 - (*filter).LP.C) / ((*filter).HP.C - (*filter).LP.C);
+		(*filter).GR = 1 / (*filter).G;
+		return;
+	};
+
+	double  sampleRate   = 0.0;
+	int32   numChannels  = 0;
+	int32   maxBlockSize = 0;
+
+	std::vector<DelayLine> latency_q;
+
+	// Plugin controls ------------------------------------------------------------------
+	double     fInput      = init_Input;
+	double     fOutput     = init_Output;
+	double     fEffect     = init_Effect;
+	double     fCurve      = init_Curve;
+	bool       fParamPhase = init_Phase;
+	overSample fParamOS    = init_OS;
+
+	bool       bBypass     = init_Bypass;
+	bool       bIn         = init_In;
+	bool       bClip       = init_Clip;
+	bool       bSplit      = init_Split;
+
+	// Internal values --------------------------------------------------------------
+	Sample64   curvepct = init_curvepct;
+	Sample64   curveA   = init_curveA;
+	Sample64   curveB   = init_curveB;
+	Sample64   curveC   = init_curveC;
+	Sample64   curveD   = init_curveD;
+	std::vector<Band_Split> bandSplit;
+
+	// VU metering ----------------------------------------------------------------
+	bool bMetering = true;
+	LevelEnvelopeFollower VuInput, VuOutput;
+	double Meter = 0.0;
+	std::vector<std::vector<double>> buff;
+	std::vector<double*> buff_head;
+
+	// channel pointers into the pieces of a split block, sized by prepare()
+	template <typename SampleType>
+	struct SplitPointers
+	{
+		std::vector<SampleType*> in, out;
+	};
+	SplitPointers<float>  split32;
+	SplitPointers<double> split64;
+	SplitPointers<float>&  splitPointers(float*)  { return split32; }
+	SplitPointers<double>& splitPointers(double*) { return split64; }
+
+	std::unique_ptr<ChannelWorker> channelWorker;
+	bool bLowFootprint = false;
+
+#ifdef JSIF_ENABLE_PROFILING
+	JSIF_Profiler profiler;
+#endif
+
+	// Oversamplers ------------------------------------------------------------------
+	using Resampler = std::unique_ptr<r8b::CDSPResampler24>;
+	std::vector<Resampler> upSample_2x_Lin;
+	std::vector<Resampler> upSample_4x_Lin;
+	std::vector<Resampler> upSample_8x_Lin;
+	std::vector<Resampler> dnSample_2x_Lin;
+	std::vector<Resampler> dnSample_4x_Lin;
+	std::vector<Resampler> dnSample_8x_Lin;
+
+	std::vector<Flt> upSample_21;
+	std::vector<Flt> upSample_41;
+	std::vector<Flt> upSample_42;
+	std::vector<Flt> upSample_81;
+	std::vector<Flt> upSample_82;
+	std::vector<Flt> upSample_83;
+
+	std::vector<Flt> dnSample_21;
+	std::vector<Flt> dnSample_41;
+	std::vector<Flt> dnSample_42;
+	std::vector<Flt> dnSample_81;
+	std::vector<Flt> dnSample_82;
+	std::vector<Flt> dnSample_83;
+
+	static constexpr int32 upTap_21 = 85;
+	static constexpr int32 upTap_41 = 83;
+	static constexpr int32 upTap_42 = 31;
+	static constexpr int32 upTap_81 = 87;
+	static constexpr int32 upTap_82 = 33;
+	static constexpr int32 upTap_83 = 21;
+
+	static constexpr int32 dnTap_21 = 113;
+	static constexpr int32 dnTap_41 = 113;
+	static constexpr int32 dnTap_42 = 31;
+	static constexpr int32 dnTap_81 = 113;
+	static constexpr int32 dnTap_82 = 33;
+	static constexpr int32 dnTap_83 = 21;
+
+	static_assert(dnTap_21 + 2 <= maxFltBuff && dnTap_41 + 2 <= maxFltBuff && dnTap_81 + 2 <= maxFltBuff,
+	              "Flt::buff too short for the down-sampling taps");
+
+	// Half-band coefficients only depend on the taps, designed once for all instances
+	struct FirTables
+	{
+		FirTables();
+		double up_21 alignas(16)[upTap_21], up_41 alignas(16)[upTap_41], up_42 alignas(16)[upTap_42];
+		double up_81 alignas(16)[upTap_81], up_82 alignas(16)[upTap_82], up_83 alignas(16)[upTap_83];
+		double dn_21 alignas(16)[dnTap_21], dn_41 alignas(16)[dnTap_41], dn_42 alignas(16)[dnTap_42];
+		double dn_81 alignas(16)[dnTap_81], dn_82 alignas(16)[dnTap_82], dn_83 alignas(16)[dnTap_83];
+	};
+	static const FirTables& firTables();
+
+	// latency_r8b_x2 = -1 + 2 * upSample_2x_Lin[0].getInLenBeforeOutPos(1) +1;
+	// latency_r8b_x4 = -1 + 2 * upSample_4x_Lin[0].getInLenBeforeOutPos(1);
+	// latency_r8b_x8 = -1 + 2 * upSample_8x_Lin[0].getInLenBeforeOutPos(1);
+	static constexpr int32 latency_r8b_x2 = 3388;
+	static constexpr int32 latency_r8b_x4 = 3431;
+	static constexpr int32 latency_r8b_x8 = 3465;
+	static constexpr int32 latency_Fir_x2 = 49;
+	static constexpr int32 latency_Fir_x4 = 56;
+	static constexpr int32 latency_Fir_x8 = 60;
+
+	void Fir_x2_up(Sample64* in, Sample64* out, int32 channel);
+	void Fir_x2_dn(Sample64* in, Sample64* out, int32 channel);
+	void Fir_x4_up(Sample64* in, Sample64* out, int32 channel);
+	void Fir_x4_dn(Sample64* in, Sample64* out, int32 channel);
+	void Fir_x8_up(Sample64* in, Sample64* out, int32 channel);
+	void Fir_x8_dn(Sample64* in, Sample64* out, int32 channel);
+};
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI        3.14159265358979323846264338327950288   /* pi             */
+#endif
+
+namespace yg331 {
+
+static constexpr int maxTap = 512;
+// The down-sampler keeps two extra input samples in front of TAP_SIZE taps
+static constexpr int maxFltBuff = 128;
+
+class Kaiser {
+public:
+	static inline double Ino(double x)
+	{
+		double d = 0, ds = 1, s = 1;
+		do
+		{
+			d += 2;
+			ds *= x * x / (d * d);
+			s += ds;
+		} while (ds > s * 1e-6);
+		return s;
+    }
+
+	static void calcFilter(double Fs, double Fa, double Fb, int M, double Att, double* dest)
+	{
+		// Kaiser windowed FIR filter "DIGITAL SIGNAL PROCESSING, II" IEEE Press pp 123-126.
+
+		int Np = (M - 1) / 2;
+		double A[maxTap] = { 0, };
+		double Alpha; //actually, Beta. This Alpha is multiplied by pi.
+		double Inoalpha;
+
+		A[0] = 2 * (Fb - Fa) / Fs;
+
+		for (int j = 1; j <= Np; j++)
+			A[j] = (sin(2.0 * j * M_PI * Fb / Fs) - sin(2.0 * j * M_PI * Fa / Fs)) / (j * M_PI);
+
+		if (Att < 21.0)
+			Alpha = 0;
+		else if (Att > 50.0)
+			Alpha = 0.1102 * (Att - 8.7);
+		else
+			Alpha = 0.5842 * pow((Att - 21), 0.4) + 0.07886 * (Att - 21);
+
+		Inoalpha = Ino(Alpha);
+
+		for (int j = 0; j <= Np; j++)
+		{
+			dest[Np + j] = A[j] * Ino(Alpha * std::sqrt(1.0 - (static_cast<double>(j * j) / static_cast<double>(Np * Np)))) / Inoalpha;
+		}
+		dest[Np + Np] = A[Np] * Ino(0.0) / Inoalpha; // ARM with optimizer level O3 returns NaN == sqrt(1.0 - n/n), while x64 does not...
+		for (int j = 0; j < Np; j++)
+		{
+			dest[j] = dest[M - 1 - j];
+		}
+
+    }
+};
+
+// Buffers ------------------------------------------------------------------
+// coef points into tables shared by every instance, only buff is per channel
+typedef struct _Flt {
+	const double* coef = nullptr;
+	double buff alignas(16)[maxFltBuff] = { 0, };
+    int TAP_SIZE = 0;
+    int TAP_HALF = 0;
+    int TAP_HALF_HALF = 0;
+    int TAP_CONDITION = 0;
+	int START = 0;
+} Flt;
+
+class Decibels
+{
+public:
+	template <typename Type>
+	static Type decibelsToGain(
+		Type decibels,
+		Type minusInfinityDb = Type(defaultMinusInfinitydB)
+	)
+	{
+		return decibels > minusInfinityDb 
+		                ? std::pow(Type(10.0), decibels * Type(0.05))
+		                : Type();
+	}
+
+	template <typename Type>
+	static Type gainToDecibels(
+		Type gain,
+		Type minusInfinityDb = Type(defaultMinusInfinitydB)
+	)
+	{
+		return gain > Type() 
+		            ? (std::max)(minusInfinityDb, static_cast<Type> (std::log10(gain)) * Type(20.0))
+		            : minusInfinityDb;
+	}
+
+private:
+	enum { defaultMinusInfinitydB = -100 };
+	Decibels() = delete; 
+};
+
+class LevelEnvelopeFollower
+{
+public:
+	LevelEnvelopeFollower() = default;
+
+	~LevelEnvelopeFollower() {
+		state.clear();
+		state.shrink_to_fit();
+	}
+
+	void setChannel(const int channels) {
+		state.resize(channels, 0.0);
+	}
+
+	enum detectionType {Peak, RMS};
+	void setType(detectionType _type)
+	{
+		type = _type;
+	}
+
+	void setDecay(double val)
+	{
+		DecayInSeconds = val;
+    }
+
+	void prepare(const double& fs)
+	{
+		sampleRate = fs;
+
+		double attackTimeInSeconds = 0.01 * DecayInSeconds;
+		alphaAttack = exp(-1.0 / (sampleRate * attackTimeInSeconds)); 
+
+		double releaseTimeInSeconds = DecayInSeconds; 
+		alphaRelease = exp(-1.0 / (sampleRate * releaseTimeInSeconds));  
+
+		for (auto& s : state)
+			s = Decibels::gainToDecibels(0.0);
+    }
+
+	template <typename SampleType>
+	void update(SampleType** channelData, int numChannels, int numSamples)
+	{
+		if (numChannels <= 0) return;
+		if (numSamples <= 0) return;
+		if (numChannels > state.size()) return;
+
+		for (int ch = 0; ch < numChannels; ch++) {
+			for (int i = 0; i < numSamples; i++) {
+				if (type == Peak) {
+					double in = Decibels::gainToDecibels(std::abs(channelData[ch][i]));
+					if (in > state[ch])
+						state[ch] = alphaAttack * state[ch] + (1.0 - alphaAttack) * in;
+					else
+						state[ch] = alphaRelease * state[ch] + (1.0 - alphaRelease) * in;
+				}
+				else {
+					double pwr = Decibels::gainToDecibels(std::abs(channelData[ch][i]) * std::abs(channelData[ch][i]));
+					state[ch] = alphaRelease * state[ch] + (1.0 - alphaRelease) * pwr;
+				}
+				
+			}
+		} 
+    }
+	
+	size_t bytes() const { return sizeof(*this) + state.capacity() * sizeof(double); }
+
+	double getEnv(int channel) {
+		if (channel < 0) return 0.0;
+		if (channel >= state.size()) return 0.0;
+
+		if (type == Peak) return Decibels::decibelsToGain(state[channel]);
+		else return std::sqrt(Decibels::decibelsToGain(state[channel]));
+    }
+
+private:
+	double sampleRate = 0.0;
+
+	double DecayInSeconds = 0.5;
+	double DecayCoef = 0.99992;
+
+	detectionType type = Peak;
+
+	std::vector<double> state;
+	double alphaAttack = 0.0;
+	double alphaRelease = 0.0;
+};
+
+// Fixed capacity FIFO used for latency compensation, the ring is allocated
+// once in prepare so the audio thread never allocates. Behaves like the
+// former std::deque: growing appends silence after the queued samples,
+// shrinking drops the oldest ones.
+class DelayLine
+{
+public:
+	void prepare(int maxDelay)
+	{
+		int size = 1;
+		while (size < maxDelay + 1) size <<= 1;
+		ring.assign(size, 0.0);
+		mask  = (uint32_t)size - 1;
+		write = 0;
+		delay = 0;
+	}
+
+	void clear()
+	{
+		std::fill(ring.begin(), ring.end(), 0.0);
+		write = 0;
+		delay = 0;
+	}
+
+	int size() const { return delay; }
+
+	size_t bytes() const { return sizeof(*this) + ring.capacity() * sizeof(double); }
+
+	/** Grows the ring to hold maxDelay samples, the queued ones are kept. Allocates. */
+	void reserve(int maxDelay)
+	{
+		if (maxDelay <= (int)mask) return;
+		int size = 1;
+		while (size < maxDelay + 1) size <<= 1;
+		std::vector<double> grown(size, 0.0);
+		for (int i = 0; i < delay; i++)
+			grown[i] = ring[(write - (uint32_t)delay + (uint32_t)i) & mask];
+		ring.swap(grown);
+		mask  = (uint32_t)size - 1;
+		write = (uint32_t)delay;
+	}
+
+	void resize(int newDelay)
+	{
+		newDelay = std::min(newDelay, (int)mask);
+		for (int i = delay; i < newDelay; i++)
+		{
+			ring[write] = 0.0;
+			write = (write + 1) & mask;
+		}
+		delay = newDelay;
+	}
+
+	/** Pushes one sample and returns the one pushed `size()` samples ago. */
+	inline double process(double in)
+	{
+		ring[write] = in;
+		double out = ring[(write - (uint32_t)delay) & mask];
+		write = (write + 1) & mask;
+		return out;
+	}
+
+private:
+	// write stays below the ring size, unsigned so the index math wraps defined
+	std::vector<double> ring;
+	uint32_t mask  = 0;
+	uint32_t write = 0;
+	int      delay = 0;
+};
+
+} // namespace yg331
@@ -0,0 +1,368 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+// Per block and per stage timing of the process path. Everything here is
+// compiled out unless JSIF_ENABLE_PROFILING is defined (CMake option of
+// the same name), the JSIF_PROFILE_* macros then expand to nothing:
+//
+//   JSIF_PROFILE_BLOCK(profiler, frames, rate);  // times the enclosing scope as one block
+//   JSIF_PROFILE_STAGES(acc, profiler, channel, oversampling, linear);
+//                                                // one channel's stage sums, flushed at scope end
+//   JSIF_PROFILE_TICK(t0); ... JSIF_PROFILE_TICK(t1);
+//   JSIF_PROFILE_ADD(acc, kShape, t1 - t0);      // adds to the stage sum
+//   JSIF_PROFILE_SPAN(acc, kShape, t0, t1);      // adds, and reports the span to a SpanSink
+//
+// A SpanSink set with setSpanSink() receives every block, channel and
+// per-block stage span as it ends, for timelines such as jsif_trace.
+
+#ifdef JSIF_ENABLE_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace yg331 {
+
+//------------------------------------------------------------------------
+//  JSIF_Profiler
+//------------------------------------------------------------------------
+// Stage ticks are accumulated per block and folded into log2 histograms
+// when the block ends. Block wall time is compared to the block deadline
+// (frames / sample rate) and kept as a load histogram in 1/16 steps.
+// Writers are the audio thread and the channel worker, readers may call
+// snapshot() from any thread. All shared state is relaxed atomics, no locks.
+class JSIF_Profiler
+{
+public:
+	enum Stage {
+		kParams = 0,   // parameter queue handling (plug-in)
+		kUpsample,
+		kShape,
+		kDownsample,
+		kMetering,
+		kMessaging,    // meter and latency output (plug-in)
+		kNumStages
+	};
+
+	static constexpr int kTickBins = 40;  // bin n holds blocks with 2^n <= ticks < 2^(n+1)
+	static constexpr int kLoadBins = 33;  // bin n holds load n/16 .. (n+1)/16, last bin >= 2.0
+
+	// Plain copy of the counters, also sent to the controller as binary
+	struct Snapshot
+	{
+		uint32_t instance = 0;
+		uint64_t blocks   = 0;
+		uint64_t overruns = 0;                  // blocks that took longer than their deadline
+		double   lastLoad = 0.0;                // wall time / deadline of the last block
+		double   maxLoad  = 0.0;
+		int32_t  maxLoadStage = -1;             // stage with most ticks in the worst block
+		uint64_t stageTicks   [kNumStages] = { 0, };
+		uint64_t stageMaxTicks[kNumStages] = { 0, };
+		uint32_t stageHist    [kNumStages][kTickBins] = { { 0, }, };
+		uint32_t loadHist     [kLoadBins] = { 0, };
+	};
+
+	static constexpr int32_t kBlockSpan   = -1;
+	static constexpr int32_t kChannelSpan = -2;
+
+	static const char* stageName(int stage)
+	{
+		static const char* names[kNumStages] = { "params", "upsample", "shape", "downsample", "metering", "messaging" };
+		if (stage == kBlockSpan)   return "block";
+		if (stage == kChannelSpan) return "channel";
+		return (stage >= 0 && stage < kNumStages) ? names[stage] : "none";
+	}
+
+	// A timed part of one block, in ticks()
+	struct Span
+	{
+		int32_t  stage;         // Stage, kBlockSpan or kChannelSpan
+		int32_t  channel;       // -1 for spans covering all channels
+		uint64_t block;         // blocks ended before this one
+		int32_t  oversampling;  // mode of the block, 0 when no channel was processed
+		bool     linearPhase;
+		bool     total;         // a stage's sum over the channel, laid out end to end from the channel's begin
+		uint64_t begin, end;
+	};
+
+	// Called on the thread that ran the span: the audio thread, or the
+	// channel worker for the channels it processes.
+	class SpanSink
+	{
+	public:
+		virtual ~SpanSink() = default;
+		virtual void span(const Span& span) = 0;
+
+		// single stage calls of a channel at least this long are also
+		// reported on their own, e.g. r8brain filling its buffers
+		uint64_t callTicks = UINT64_MAX;
+	};
+
+	/** Cycle counter where the CPU has one, steady clock nanoseconds otherwise. */
+	static inline uint64_t ticks()
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t v;
+		asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+		return v;
+#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	JSIF_Profiler() : instance(nextInstance().fetch_add(1) + 1) { clear(); }
+
+	JSIF_Profiler(const JSIF_Profiler&) = delete;
+	JSIF_Profiler& operator=(const JSIF_Profiler&) = delete;
+
+	bool inBlock() const { return active; }
+
+	/** Set between blocks, nullptr stops reporting. The sink must outlive its use. */
+	void setSpanSink(SpanSink* newSink) { sink.store(newSink, std::memory_order_relaxed); }
+
+	void beginBlock()
+	{
+		for (auto& t : blockTicks) t.store(0, std::memory_order_relaxed);
+		blockStart = std::chrono::steady_clock::now();
+		blockBegin = ticks();
+		block = blocks.load(std::memory_order_relaxed);
+		setMode(0, false);
+		active = true;
+	}
+
+	inline void addStage(Stage stage, uint64_t t)
+	{
+		blockTicks[stage].fetch_add(t, std::memory_order_relaxed);
+	}
+
+	/** A whole-block stage, reported to the sink as one span. */
+	void addSpan(Stage stage, uint64_t begin, uint64_t end)
+	{
+		addStage(stage, end - begin);
+		if (SpanSink* s = sink.load(std::memory_order_relaxed))
+			s->span({ stage, -1, block, oversampling.load(std::memory_order_relaxed),
+			          linearPhase.load(std::memory_order_relaxed), false, begin, end });
+	}
+
+	void setMode(int32_t newOversampling, bool newLinearPhase)
+	{
+		oversampling.store(newOversampling, std::memory_order_relaxed);
+		linearPhase.store(newLinearPhase, std::memory_order_relaxed);
+	}
+
+	void endBlock(int32_t frames, double sampleRate)
+	{
+		active = false;
+		if (SpanSink* s = sink.load(std::memory_order_relaxed))
+			s->span({ kBlockSpan, -1, block, oversampling.load(std::memory_order_relaxed),
+			          linearPhase.load(std::memory_order_relaxed), false, blockBegin, ticks() });
+		if (frames <= 0 || sampleRate <= 0.0)
+			return;
+
+		double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count();
+		double load = wall * sampleRate / (double)frames;
+
+		int32_t worst = -1;
+		uint64_t worstTicks = 0;
+		for (int s = 0; s < kNumStages; s++)
+		{
+			uint64_t t = blockTicks[s].load(std::memory_order_relaxed);
+			if (t == 0) continue;
+			stageTicks[s].fetch_add(t, std::memory_order_relaxed);
+			if (t > stageMaxTicks[s].load(std::memory_order_relaxed))
+				stageMaxTicks[s].store(t, std::memory_order_relaxed);
+			stageHist[s][log2Bin(t)].fetch_add(1, std::memory_order_relaxed);
+			if (t > worstTicks) { worstTicks = t; worst = s; }
+		}
+
+		int bin = (int)(load * 16.0);
+		loadHist[bin < kLoadBins - 1 ? bin : kLoadBins - 1].fetch_add(1, std::memory_order_relaxed);
+		blocks.fetch_add(1, std::memory_order_relaxed);
+		if (load > 1.0)
+			overruns.fetch_add(1, std::memory_order_relaxed);
+
+		lastLoad.store(load, std::memory_order_relaxed);
+		if (load > maxLoad.load(std::memory_order_relaxed))
+		{
+			maxLoad.store(load, std::memory_order_relaxed);
+			maxLoadStage.store(worst, std::memory_order_relaxed);
+		}
+	}
+
+	void snapshot(Snapshot& out) const
+	{
+		out.instance     = instance;
+		out.blocks       = blocks.load(std::memory_order_relaxed);
+		out.overruns     = overruns.load(std::memory_order_relaxed);
+		out.lastLoad     = lastLoad.load(std::memory_order_relaxed);
+		out.maxLoad      = maxLoad.load(std::memory_order_relaxed);
+		out.maxLoadStage = maxLoadStage.load(std::memory_order_relaxed);
+		for (int s = 0; s < kNumStages; s++)
+		{
+			out.stageTicks[s]    = stageTicks[s].load(std::memory_order_relaxed);
+			out.stageMaxTicks[s] = stageMaxTicks[s].load(std::memory_order_relaxed);
+			for (int b = 0; b < kTickBins; b++)
+				out.stageHist[s][b] = stageHist[s][b].load(std::memory_order_relaxed);
+		}
+		for (int b = 0; b < kLoadBins; b++)
+			out.loadHist[b] = loadHist[b].load(std::memory_order_relaxed);
+	}
+
+	/** Resets the statistics, a block in flight may still land in the old ones. */
+	void clear()
+	{
+		for (int s = 0; s < kNumStages; s++)
+		{
+			blockTicks[s].store(0, std::memory_order_relaxed);
+			stageTicks[s].store(0, std::memory_order_relaxed);
+			stageMaxTicks[s].store(0, std::memory_order_relaxed);
+			for (auto& b : stageHist[s]) b.store(0, std::memory_order_relaxed);
+		}
+		for (auto& b : loadHist) b.store(0, std::memory_order_relaxed);
+		blocks.store(0, std::memory_order_relaxed);
+		overruns.store(0, std::memory_order_relaxed);
+		lastLoad.store(0.0, std::memory_order_relaxed);
+		maxLoad.store(0.0, std::memory_order_relaxed);
+		maxLoadStage.store(-1, std::memory_order_relaxed);
+	}
+
+	uint32_t getInstance() const { return instance; }
+	double   getLastLoad() const { return lastLoad.load(std::memory_order_relaxed); }
+
+	// Stage sums of one channel, folded into the block on destruction so the
+	// per sample loops don't touch shared cache lines. With a sink set the
+	// channel and its stage sums are reported then too.
+	class StageScope
+	{
+	public:
+		StageScope(JSIF_Profiler& p, int32_t channel, int32_t oversampling, bool linearPhase)
+			: profiler(p), sink(p.sink.load(std::memory_order_relaxed)), channel(channel),
+			  oversampling(oversampling), linearPhase(linearPhase)
+		{
+			profiler.setMode(oversampling, linearPhase);
+			if (sink)
+			{
+				callTicks = sink->callTicks;
+				begin = ticks();
+			}
+		}
+		~StageScope()
+		{
+			for (int s = 0; s < kNumStages; s++)
+				if (sum[s]) profiler.addStage((Stage)s, sum[s]);
+			if (!sink)
+				return;
+			const uint64_t end = ticks();
+			uint64_t at = begin;
+			for (int s = 0; s < kNumStages; s++)
+			{
+				if (!sum[s]) continue;
+				sink->span({ s, channel, profiler.block, oversampling, linearPhase, true, at, at + sum[s] });
+				at += sum[s];
+			}
+			sink->span({ kChannelSpan, channel, profiler.block, oversampling, linearPhase, false, begin, end });
+		}
+		inline void addStage(Stage stage, uint64_t t) { sum[stage] += t; }
+		inline void addSpan(Stage stage, uint64_t spanBegin, uint64_t spanEnd)
+		{
+			sum[stage] += spanEnd - spanBegin;
+			if (spanEnd - spanBegin >= callTicks)
+				sink->span({ stage, channel, profiler.block, oversampling, linearPhase, false, spanBegin, spanEnd });
+		}
+	private:
+		JSIF_Profiler& profiler;
+		SpanSink* const sink;
+		const int32_t channel;
+		const int32_t oversampling;
+		const bool linearPhase;
+		uint64_t callTicks = UINT64_MAX;
+		uint64_t begin = 0;
+		uint64_t sum[kNumStages] = { 0, };
+	};
+
+	// Wraps the outermost caller's block, nested scopes do nothing
+	class BlockScope
+	{
+	public:
+		BlockScope(JSIF_Profiler& p, int32_t frames, double sampleRate)
+			: profiler(p), frames(frames), sampleRate(sampleRate), owner(!p.inBlock())
+		{
+			if (owner) profiler.beginBlock();
+		}
+		~BlockScope() { if (owner) profiler.endBlock(frames, sampleRate); }
+	private:
+		JSIF_Profiler& profiler;
+		int32_t frames;
+		double sampleRate;
+		bool owner;
+	};
+
+private:
+	static std::atomic<uint32_t>& nextInstance()
+	{
+		static std::atomic<uint32_t> counter { 0 };
+		return counter;
+	}
+
+	static int log2Bin(uint64_t t)
+	{
+		int bin = 0;
+		while (t > 1 && bin < kTickBins - 1) { t >>= 1; bin++; }
+		return bin;
+	}
+
+	const uint32_t instance;
+	bool active = false;
+	std::chrono::steady_clock::time_point blockStart;
+	uint64_t blockBegin = 0;
+	uint64_t block = 0;
+
+	std::atomic<SpanSink*> sink { nullptr };
+	std::atomic<int32_t>   oversampling { 0 };
+	std::atomic<bool>      linearPhase { false };
+
+	std::atomic<uint64_t> blockTicks   [kNumStages];
+	std::atomic<uint64_t> stageTicks   [kNumStages];
+	std::atomic<uint64_t> stageMaxTicks[kNumStages];
+	std::atomic<uint32_t> stageHist    [kNumStages][kTickBins];
+	std::atomic<uint32_t> loadHist     [kLoadBins];
+	std::atomic<uint64_t> blocks;
+	std::atomic<uint64_t> overruns;
+	std::atomic<double>   lastLoad;
+	std::atomic<double>   maxLoad;
+	std::atomic<int32_t>  maxLoadStage;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
+
+#define JSIF_PROFILE_BLOCK(profiler, frames, rate) yg331::JSIF_Profiler::BlockScope jsifProfileBlock((profiler), (frames), (rate))
+#define JSIF_PROFILE_STAGES(name, profiler, channel, oversampling, linear) \
+	yg331::JSIF_Profiler::StageScope name((profiler), (channel), (oversampling), (linear))
+#define JSIF_PROFILE_TICK(name)                    const uint64_t name = yg331::JSIF_Profiler::ticks()
+#define JSIF_PROFILE_ADD(target, stage, ticks)     (target).addStage(yg331::JSIF_Profiler::stage, (ticks))
+#define JSIF_PROFILE_SPAN(target, stage, begin, end) (target).addSpan(yg331::JSIF_Profiler::stage, (begin), (end))
+
+#else
+
+#define JSIF_PROFILE_BLOCK(profiler, frames, rate)
+#define JSIF_PROFILE_STAGES(name, profiler, channel, oversampling, linear)
+#define JSIF_PROFILE_TICK(name)
+#define JSIF_PROFILE_ADD(target, stage, ticks)
+#define JSIF_PROFILE_SPAN(target, stage, begin, end)
+
+#endif // JSIF_ENABLE_PROFILING
@@ -0,0 +1,231 @@
+/*------------------------------------------------------------------------
+ * Copyright(c) 2024 yg331.
+ *------------------------------------------------------------------------
+ * jsif_capi - the C ABI of libjsif, compiled as C against the shared library.
+ *
+ * Checks the error codes, that the dry path peaks at jsif_get_latency(),
+ * that in place and separate buffers give the same output, that the float
+ * path follows the double one, that jsif_reset() restores the state after
+ * prepare, that a parameter set between blocks applies to the next one and
+ * that a call longer than max_block is split for every channel.
+ *
+ *   jsif_capi
+ *------------------------------------------------------------------------*/
+
+#include "JSIF_capi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CHANNELS 2
+#define FRAMES   8192
+#define BLOCK    512
+
+/* more channels than a fixed pointer array would hold */
+#define WIDE_CHANNELS 40
+#define WIDE_BLOCK    64
+#define WIDE_FRAMES   (4 * WIDE_BLOCK)
+
+static int failed = 0;
+
+static void check(int condition, const char* what)
+{
+	if (!condition) { fprintf(stderr, "FAIL %s\n", what); failed++; }
+}
+
+static double absolute(double v) { return v < 0.0 ? -v : v; }
+
+static unsigned int seed = 0x9E3779B9u;
+static double noise(void)
+{
+	seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+	return (double)seed / 2147483648.0 - 1.0;
+}
+
+static double input[CHANNELS][FRAMES];
+
+static jsif_instance* make(double os, double phase, double effect)
+{
+	jsif_instance* instance = jsif_create();
+	jsif_set_param(instance, JSIF_PARAM_OS, os);
+	jsif_set_param(instance, JSIF_PARAM_PHASE, phase);
+	jsif_set_param(instance, JSIF_PARAM_EFFECT, effect);
+	jsif_set_param(instance, JSIF_PARAM_CURVE, 0.7);
+	jsif_set_param(instance, JSIF_PARAM_SPLIT, 1.0);
+	jsif_prepare(instance, 48000.0, CHANNELS, BLOCK);
+	return instance;
+}
+
+/* input through instance in blocks, in place or into separate buffers */
+static void render(jsif_instance* instance, double out[CHANNELS][FRAMES], int inPlace)
+{
+	int offset, ch;
+	for (offset = 0; offset < FRAMES; offset += BLOCK)
+	{
+		const double* in[CHANNELS];
+		double* o[CHANNELS];
+		for (ch = 0; ch < CHANNELS; ch++)
+		{
+			if (inPlace) memcpy(out[ch] + offset, input[ch] + offset, BLOCK * sizeof(double));
+			in[ch] = inPlace ? out[ch] + offset : input[ch] + offset;
+			o[ch]  = out[ch] + offset;
+		}
+		jsif_process_f64(instance, in, o, CHANNELS, BLOCK);
+	}
+}
+
+static double a[CHANNELS][FRAMES], b[CHANNELS][FRAMES];
+static float  f[CHANNELS][FRAMES];
+static double wide[2][WIDE_CHANNELS][WIDE_FRAMES];
+
+int main(void)
+{
+	int ch, i, os;
+	jsif_instance* instance;
+
+	for (ch = 0; ch < CHANNELS; ch++)
+		for (i = 0; i < FRAMES; i++)
+			input[ch][i] = 0.7 * noise();
+
+	check(jsif_api_version() == JSIF_API_VERSION, "api version");
+
+	/* errors */
+	instance = jsif_create();
+	{
+		const double* in[CHANNELS] = { a[0], a[1] };
+		double* out[CHANNELS] = { a[0], a[1] };
+		check(jsif_process_f64(instance, in, out, CHANNELS, BLOCK) == JSIF_ERROR_NOT_PREPARED, "process before prepare");
+		check(jsif_reset(instance) == JSIF_ERROR_NOT_PREPARED, "reset before prepare");
+		check(jsif_prepare(instance, 0.0, CHANNELS, BLOCK) == JSIF_ERROR_INVALID_ARGUMENT, "prepare at 0 Hz");
+		check(jsif_prepare(instance, 48000.0, CHANNELS, BLOCK) == JSIF_OK, "prepare");
+		check(jsif_process_f64(instance, in, out, CHANNELS + 1, BLOCK) == JSIF_ERROR_INVALID_ARGUMENT, "more channels than prepared");
+		check(jsif_process_f64(instance, NULL, out, CHANNELS, BLOCK) == JSIF_ERROR_INVALID_ARGUMENT, "null input");
+		check(jsif_process_f64(NULL, in, out, CHANNELS, BLOCK) == JSIF_ERROR_INVALID_ARGUMENT, "null instance");
+		check(jsif_process_f64(instance, in, out, CHANNELS, 0) == JSIF_OK, "empty block");
+		check(jsif_set_param(instance, JSIF_PARAM_COUNT, 0.5) == JSIF_ERROR_INVALID_ARGUMENT, "unknown parameter");
+		check(jsif_set_param(instance, JSIF_PARAM_EFFECT, 2.0) == JSIF_OK && jsif_get_param(instance, JSIF_PARAM_EFFECT) == 1.0,
+		      "parameter clamped");
+		check(jsif_get_param(instance, JSIF_PARAM_CURVE) == 0.5, "default curve");
+	}
+	jsif_destroy(instance);
+	jsif_destroy(NULL);
+
+	/* the dry path peaks at the reported latency */
+	for (os = 0; os < 4; os++)
+	{
+		int phase;
+		for (phase = 0; phase < 2; phase++)
+		{
+			static double impulse[CHANNELS][FRAMES];
+			int peak = 0, latency;
+			char name[64];
+			instance = make(os / 3.0, phase, 0.0);
+			latency = jsif_get_latency(instance);
+			memset(impulse, 0, sizeof(impulse));
+			impulse[0][0] = impulse[1][0] = 1.0;
+			memcpy(a, impulse, sizeof(a));
+			{
+				int offset;
+				for (offset = 0; offset < FRAMES; offset += BLOCK)
+				{
+					double* p[CHANNELS] = { a[0] + offset, a[1] + offset };
+					jsif_process_f64(instance, (const double* const*)p, p, CHANNELS, BLOCK);
+				}
+			}
+			for (i = 1; i < FRAMES; i++)
+				if (absolute(a[0][i]) > absolute(a[0][peak])) peak = i;
+			snprintf(name, sizeof(name), "x%d %s dry peak %d, latency %d", 1 << os, phase ? "r8b" : "fir", peak, latency);
+			check(peak == latency, name);
+			jsif_destroy(instance);
+		}
+	}
+
+	/* in place, separate buffers, float, reset */
+	for (os = 0; os < 4; os++)
+	{
+		jsif_instance* separate = make(os / 3.0, 0.0, 0.8);
+		jsif_instance* inPlace  = make(os / 3.0, 0.0, 0.8);
+		double err = 0.0;
+		int offset;
+
+		render(separate, a, 0);
+		render(inPlace, b, 1);
+		check(memcmp(a, b, sizeof(a)) == 0, "in place differs from separate buffers");
+
+		jsif_reset(separate);
+		render(separate, b, 0);
+		check(memcmp(a, b, sizeof(a)) == 0, "output after reset differs from after prepare");
+
+		jsif_reset(inPlace);
+		for (ch = 0; ch < CHANNELS; ch++)
+			for (i = 0; i < FRAMES; i++)
+				f[ch][i] = (float)input[ch][i];
+		for (offset = 0; offset < FRAMES; offset += BLOCK)
+		{
+			float* p[CHANNELS] = { f[0] + offset, f[1] + offset };
+			jsif_process_f32(inPlace, (const float* const*)p, p, CHANNELS, BLOCK);
+		}
+		for (ch = 0; ch < CHANNELS; ch++)
+			for (i = 0; i < FRAMES; i++)
+				if (absolute(f[ch][i] - a[ch][i]) > err) err = absolute(f[ch][i] - a[ch][i]);
+		check(err < 1e-5, "float path differs from double");
+
+		jsif_destroy(separate);
+		jsif_destroy(inPlace);
+	}
+
+	/* a parameter set between blocks applies from the next block */
+	instance = make(0.0, 0.0, 1.0);
+	{
+		const double* in[CHANNELS] = { input[0], input[1] };
+		const double* rest[CHANNELS] = { input[0] + BLOCK, input[1] + BLOCK };
+		double* out[CHANNELS] = { a[0], a[1] };
+		double* outRest[CHANNELS] = { a[0] + BLOCK, a[1] + BLOCK };
+		jsif_process_f64(instance, in, out, CHANNELS, BLOCK);
+		check(memcmp(a[0], input[0], BLOCK * sizeof(double)) != 0, "effect at 100 % left the input unchanged");
+		jsif_set_param(instance, JSIF_PARAM_BYPASS, 1.0);
+		jsif_process_f64(instance, rest, outRest, CHANNELS, FRAMES - BLOCK);
+		check(memcmp(a[0] + BLOCK, input[0] + BLOCK, (FRAMES - BLOCK) * sizeof(double)) == 0, "bypass at x1 is not transparent");
+	}
+	jsif_destroy(instance);
+
+	/* one call of 4 * max_block equals 4 calls of max_block on all channels */
+	{
+		jsif_instance* split   = jsif_create();
+		jsif_instance* blocked = jsif_create();
+		const double* in[WIDE_CHANNELS];
+		double* out[WIDE_CHANNELS];
+		int offset, k;
+		for (k = 0; k < 2; k++)
+		{
+			jsif_instance* wideInstance = k ? blocked : split;
+			jsif_set_param(wideInstance, JSIF_PARAM_EFFECT, 0.8);
+			check(jsif_prepare(wideInstance, 48000.0, WIDE_CHANNELS, WIDE_BLOCK) == JSIF_OK, "prepare 40 channels");
+			for (ch = 0; ch < WIDE_CHANNELS; ch++)
+				for (i = 0; i < WIDE_FRAMES; i++)
+					wide[k][ch][i] = 123.0;
+		}
+		for (ch = 0; ch < WIDE_CHANNELS; ch++)
+		{
+			in[ch]  = input[ch % CHANNELS] + ch;
+			out[ch] = wide[0][ch];
+		}
+		jsif_process_f64(split, in, out, WIDE_CHANNELS, WIDE_FRAMES);
+		for (offset = 0; offset < WIDE_FRAMES; offset += WIDE_BLOCK)
+		{
+			for (ch = 0; ch < WIDE_CHANNELS; ch++)
+			{
+				in[ch]  = input[ch % CHANNELS] + ch + offset;
+				out[ch] = wide[1][ch] + offset;
+			}
+			jsif_process_f64(blocked, in, out, WIDE_CHANNELS, WIDE_BLOCK);
+		}
+		check(wide[0][WIDE_CHANNELS - 1][WIDE_FRAMES - 1] != 123.0, "last channel of a split call left unprocessed");
+		check(memcmp(wide[0], wide[1], sizeof(wide[0])) == 0, "split call differs from max_block calls");
+		jsif_destroy(split);
+		jsif_destroy(blocked);
+	}
+
+	printf("jsif_capi: %s\n", failed ? "failed" : "passed");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,625 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_golden - golden output regression test for JSIF_DSP.
+//
+// Renders fixed test signals (sweep, noise, transients, DC, near-clip)
+// through every OS / Phase / Split / Clip combination and compares against
+// the references in golden/jsif_golden.bin:
+//
+//   exact   (default) the double path must hash bit-identical, the float
+//           I/O path must stay within the float tolerance of the reference.
+//   bounded (--bounded) every frame of a short render of each case is
+//           compared with its stored double reference, within the per-mode
+//           error bounds of toleranceFor(), for SIMD or reassociated math
+//           that cannot stay bit-exact.
+//
+// Latency is checked for every mode: the dry path must peak exactly at
+// getLatencySamples(), the oversampled wet path within one sample of it.
+//
+// References hold a 64 bit hash of the kFrames double output and every
+// frame of the kBoundedFrames render per case. The hashes are only valid
+// for the toolchain that wrote them, so ctest runs --bounded and exact is a
+// local check. Cases without a reference are reported as skipped, --update
+// rewrites the file from the current build, --no-r8b leaves the r8brain
+// modes out when recording without the real library.
+//
+// The committed references were recorded with --no-r8b: the linear phase
+// (r8brain) modes are not covered by them, only by the latency, reset and
+// pre-roll checks that need no reference.
+//
+// Every OS / Phase mode must render the same after JSIF_DSP::reset() on a
+// used instance as on a freshly prepared one.
+//
+// A fresh instance started getSettleSamples() early must continue a stream
+// within kPrerollTolerance of the instance that processed all of it.
+//
+// --low-footprint runs every case with JSIF_DSP::setLowFootprint(), against
+// the same references, and also compares a render that switches OS / Phase
+// every block with the default configuration bit for bit.
+//
+//   jsif_golden --ref golden/jsif_golden.bin [--bounded] [--update] [--no-r8b] [--low-footprint] [--verbose]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+static constexpr double  kSampleRate = 48000.0;
+static constexpr int32_t kFrames     = 4096;
+static constexpr int32_t kChannels   = 2;
+static constexpr int32_t kBlock      = 512;
+
+// the per-frame references: the same signals, shorter, in smaller blocks
+// so that they still cross block boundaries
+static constexpr int32_t kBoundedFrames = 512;
+static constexpr int32_t kBoundedBlock  = 128;
+
+bool lowFootprint = false;
+
+//------------------------------------------------------------------------
+// Per mode error bounds, absolute, on a full scale of 1.0
+struct Tolerance
+{
+	double bounded;  // double path with --bounded
+	double floatIO;  // float in/out against the double reference
+};
+
+Tolerance toleranceFor(int os, bool linear)
+{
+	if (os == 1) return { 1e-12, 2e-6 };
+	if (linear)  return { 1e-7,  4e-6 };
+	return              { 1e-9,  2e-6 };
+}
+
+//------------------------------------------------------------------------
+struct Case
+{
+	std::string signal;
+	int  os     = 1;
+	bool linear = false;
+	bool split  = false;
+	bool clip   = false;
+
+	std::string name() const
+	{
+		char buf[128];
+		snprintf(buf, sizeof(buf), "%s/x%d/%s%s%s", signal.c_str(), os, linear ? "r8b" : "fir",
+		         split ? "/split" : "", clip ? "/clip" : "");
+		return buf;
+	}
+};
+
+struct Reference
+{
+	uint64_t hash = 0;             // kFrames render
+	std::vector<double> frames;    // kBoundedFrames render, [frame][channel]
+};
+
+//------------------------------------------------------------------------
+// Deterministic signals, independent of the standard library's distributions
+class Noise
+{
+public:
+	explicit Noise(uint32_t seed) : state(seed) {}
+	double next()
+	{
+		state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+		return (double)state / 2147483648.0 - 1.0;
+	}
+private:
+	uint32_t state;
+};
+
+double makeSample(const std::string& signal, int32_t channel, int32_t i, int32_t frames, Noise& noise)
+{
+	const double t = (double)i / kSampleRate;
+	if (signal == "sweep")
+	{
+		// 20 Hz .. 20 kHz logarithmic, right channel a quarter turn later
+		const double T = (double)frames / kSampleRate, k = std::log(1000.0);
+		double phase = 2.0 * M_PI * 20.0 * T / k * (std::exp(k * t / T) - 1.0);
+		return 0.5 * std::sin(phase + channel * M_PI * 0.5);
+	}
+	if (signal == "noise")
+		return 0.7 * noise.next();
+	if (signal == "transient")
+	{
+		// clicks and short decaying bursts on an otherwise silent line
+		int32_t pos = i % 1024;
+		if (pos == 0)   return (channel == 0) ? 0.9 : -0.9;
+		if (pos >= 300 && pos < 400)
+			return 0.8 * std::exp(-(double)(pos - 300) / 20.0) * std::sin(2.0 * M_PI * 3000.0 * t);
+		return 0.0;
+	}
+	if (signal == "dc")
+		return (i < frames / 2) ? 0.5 : -0.25 + 0.05 * channel;
+	if (signal == "nearclip")
+	{
+		// peaks around and above full scale, plus overs to hit the +-2 limiter
+		double s = 0.99 * std::sin(2.0 * M_PI * 997.0 * t);
+		if (i % 512 < 16) s *= 2.5;
+		return s;
+	}
+	return 0.0;
+}
+
+const char* kSignals[] = { "sweep", "noise", "transient", "dc", "nearclip" };
+
+void setParams(JSIF_DSP& dsp, const Case& c)
+{
+	dsp.setInput(0.55);   // +1.2 dB
+	dsp.setEffect(0.8);
+	dsp.setCurve(0.7);
+	dsp.setOutput(0.9);
+	dsp.setOverSample(c.os == 2 ? overSample_2x : c.os == 4 ? overSample_4x : c.os == 8 ? overSample_8x : overSample_1x);
+	dsp.setLinearPhase(c.linear);
+	dsp.setSplit(c.split);
+	dsp.setClip(c.clip);
+	dsp.setIn(true);
+	dsp.setBypass(false);
+}
+
+void configure(JSIF_DSP& dsp, const Case& c)
+{
+	dsp.setLowFootprint(lowFootprint);
+	dsp.prepare(kSampleRate, kChannels, kBlock);
+	setParams(dsp, c);
+}
+
+template <typename SampleType>
+std::vector<std::vector<double>> renderWith(JSIF_DSP& dsp, const Case& c, int32_t frames = kFrames, int32_t block = kBlock)
+{
+	std::vector<std::vector<SampleType>> io(kChannels, std::vector<SampleType>(frames));
+	for (int32_t ch = 0; ch < kChannels; ch++)
+	{
+		Noise noise(0x9E3779B9u + ch);
+		for (int32_t i = 0; i < frames; i++)
+			io[ch][i] = (SampleType)makeSample(c.signal, ch, i, frames, noise);
+	}
+
+	for (int32_t offset = 0; offset < frames; offset += block)
+	{
+		SampleType* ptr[kChannels];
+		for (int32_t ch = 0; ch < kChannels; ch++) ptr[ch] = io[ch].data() + offset;
+		dsp.process(ptr, ptr, kChannels, std::min(block, frames - offset));
+	}
+
+	std::vector<std::vector<double>> out(kChannels, std::vector<double>(frames));
+	for (int32_t ch = 0; ch < kChannels; ch++)
+		for (int32_t i = 0; i < frames; i++)
+			out[ch][i] = (double)io[ch][i];
+	return out;
+}
+
+template <typename SampleType>
+std::vector<std::vector<double>> render(const Case& c, int32_t frames = kFrames, int32_t block = kBlock)
+{
+	JSIF_DSP dsp;
+	configure(dsp, c);
+	return renderWith<SampleType>(dsp, c, frames, block);
+}
+
+// FNV-1a over the raw bits, in frame order
+uint64_t hashOf(const std::vector<std::vector<double>>& out)
+{
+	uint64_t h = 1469598103934665603ull;
+	for (size_t i = 0; i < out[0].size(); i++)
+		for (int32_t ch = 0; ch < kChannels; ch++)
+		{
+			uint64_t bits;
+			memcpy(&bits, &out[ch][i], sizeof(bits));
+			for (int b = 0; b < 8; b++)
+			{
+				h ^= (bits >> (8 * b)) & 0xff;
+				h *= 1099511628211ull;
+			}
+		}
+	return h;
+}
+
+// full is the kFrames render, bounded the kBoundedFrames one
+Reference makeReference(const std::vector<std::vector<double>>& full, const std::vector<std::vector<double>>& bounded)
+{
+	Reference ref;
+	ref.hash = hashOf(full);
+	for (int32_t i = 0; i < kBoundedFrames; i++)
+		for (int32_t ch = 0; ch < kChannels; ch++)
+			ref.frames.push_back(bounded[ch][i]);
+	return ref;
+}
+
+// largest difference over every frame of a kBoundedFrames render
+double maxFrameError(const Reference& ref, const std::vector<std::vector<double>>& bounded)
+{
+	if (ref.frames.size() != (size_t)kBoundedFrames * kChannels) return INFINITY;
+	double err = 0.0;
+	size_t n = 0;
+	for (int32_t i = 0; i < kBoundedFrames; i++)
+		for (int32_t ch = 0; ch < kChannels; ch++, n++)
+			err = std::max(err, std::abs(bounded[ch][i] - ref.frames[n]));
+	return err;
+}
+
+//------------------------------------------------------------------------
+// golden file: "JSIFGLD2", uint32 frames, channels, bounded frames, bounded block, count,
+// then per case uint16 name length, name, uint64 hash, uint32 n, double[n]; little endian
+static const char kMagic[8] = { 'J', 'S', 'I', 'F', 'G', 'L', 'D', '2' };
+
+bool readGolden(const std::string& path, std::map<std::string, Reference>& refs)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) return false;
+
+	bool ok = true;
+	char magic[8];
+	uint32_t header[5];
+	if (fread(magic, 1, 8, f) != 8 || memcmp(magic, kMagic, 8) != 0 ||
+	    fread(header, sizeof(uint32_t), 5, f) != 5 ||
+	    header[0] != (uint32_t)kFrames || header[1] != (uint32_t)kChannels ||
+	    header[2] != (uint32_t)kBoundedFrames || header[3] != (uint32_t)kBoundedBlock)
+		ok = false;
+
+	for (uint32_t c = 0; ok && c < header[4]; c++)
+	{
+		uint16_t len = 0;
+		std::string name;
+		Reference ref;
+		uint32_t n = 0;
+		ok = fread(&len, sizeof(len), 1, f) == 1;
+		if (ok) { name.resize(len); ok = fread(&name[0], 1, len, f) == len; }
+		if (ok) ok = fread(&ref.hash, sizeof(ref.hash), 1, f) == 1 && fread(&n, sizeof(n), 1, f) == 1;
+		if (ok) { ref.frames.resize(n); ok = fread(ref.frames.data(), sizeof(double), n, f) == n; }
+		if (ok) refs[name] = std::move(ref);
+	}
+	fclose(f);
+	if (!ok) fprintf(stderr, "jsif_golden: %s is not a valid reference file for this build\n", path.c_str());
+	return ok;
+}
+
+bool writeGolden(const std::string& path, const std::map<std::string, Reference>& refs)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f) return false;
+	uint32_t header[5] = { (uint32_t)kFrames, (uint32_t)kChannels, (uint32_t)kBoundedFrames, (uint32_t)kBoundedBlock,
+	                       (uint32_t)refs.size() };
+	fwrite(kMagic, 1, 8, f);
+	fwrite(header, sizeof(uint32_t), 5, f);
+	for (auto& it : refs)
+	{
+		uint16_t len = (uint16_t)it.first.size();
+		uint32_t n   = (uint32_t)it.second.frames.size();
+		fwrite(&len, sizeof(len), 1, f);
+		fwrite(it.first.data(), 1, len, f);
+		fwrite(&it.second.hash, sizeof(it.second.hash), 1, f);
+		fwrite(&n, sizeof(n), 1, f);
+		fwrite(it.second.frames.data(), sizeof(double), n, f);
+	}
+	return fclose(f) == 0;
+}
+
+//------------------------------------------------------------------------
+// Impulse response peak position with the shaper out of the way
+int32_t impulsePeak(const Case& c, double effect)
+{
+	JSIF_DSP dsp;
+	configure(dsp, c);
+	dsp.setIn(false);
+	dsp.setInput(0.5);
+	dsp.setOutput(1.0);
+	dsp.setEffect(effect);
+
+	const int32_t frames = JSIF_DSP::maxLatency + kBlock * 2;
+	std::vector<double> x(frames, 0.0);
+	x[0] = 0.5;
+	for (int32_t offset = 0; offset < frames; offset += kBlock)
+	{
+		double* ptr[2] = { x.data() + offset, x.data() + offset };
+		dsp.process(ptr, ptr, 1, std::min(kBlock, frames - offset));
+	}
+
+	int32_t peak = 0;
+	for (int32_t i = 1; i < frames; i++)
+		if (std::abs(x[i]) > std::abs(x[peak])) peak = i;
+	return peak;
+}
+
+int32_t expectedLatency(const Case& c)
+{
+	JSIF_DSP dsp;
+	configure(dsp, c);
+	return dsp.getLatencySamples();
+}
+
+//------------------------------------------------------------------------
+// Noise through every OS / Phase mode in turn, one block each, so resamplers
+// and latency rings are created and grown in the middle of the stream.
+uint64_t switchHash(bool low, bool noLinear)
+{
+	struct Mode { overSample os; bool linear; };
+	static const Mode modes[] = { { overSample_2x, false }, { overSample_2x, true }, { overSample_1x, false },
+	                              { overSample_8x, true  }, { overSample_4x, false }, { overSample_4x, true },
+	                              { overSample_8x, false }, { overSample_2x, true } };
+
+	JSIF_DSP dsp;
+	Case c;
+	c.signal = "noise";
+	configure(dsp, c);
+	dsp.setLowFootprint(low);
+	dsp.prepare(kSampleRate, kChannels, kBlock);
+
+	std::vector<std::vector<double>> io(kChannels, std::vector<double>(kFrames));
+	for (int32_t ch = 0; ch < kChannels; ch++)
+	{
+		Noise noise(0x85EBCA6Bu + ch);
+		for (int32_t i = 0; i < kFrames; i++)
+			io[ch][i] = makeSample(c.signal, ch, i, kFrames, noise);
+	}
+
+	int block = 0;
+	for (int32_t offset = 0; offset < kFrames; offset += kBlock, block++)
+	{
+		const Mode& mode = modes[block % (sizeof(modes) / sizeof(modes[0]))];
+		dsp.setOverSample(mode.os);
+		dsp.setLinearPhase(mode.linear && !noLinear);
+
+		double* ptr[kChannels];
+		for (int32_t ch = 0; ch < kChannels; ch++) ptr[ch] = io[ch].data() + offset;
+		dsp.process(ptr, ptr, kChannels, std::min(kBlock, kFrames - offset));
+	}
+	return hashOf(io);
+}
+
+//------------------------------------------------------------------------
+// An instance used in other modes, then reset() and given the case's
+// parameters, must render exactly like a freshly prepared one.
+uint64_t resetHash(const Case& c, bool noLinear)
+{
+	JSIF_DSP dsp;
+	Case other = c;
+	other.signal = "sweep";
+	other.os     = c.os == 8 ? 2 : 8;
+	other.linear = !c.linear && !noLinear;
+	configure(dsp, other);
+	renderWith<double>(dsp, other);
+	// the case's own mode last, its filters are left with the sweep's tail
+	other.os     = c.os;
+	other.linear = c.linear;
+	other.clip   = !c.clip;
+	setParams(dsp, other);
+	renderWith<double>(dsp, other);
+
+	dsp.reset();
+	setParams(dsp, c);
+	return hashOf(renderWith<double>(dsp, c));
+}
+
+//------------------------------------------------------------------------
+// A fresh instance that starts getSettleSamples() before a point in a stream
+// must continue it like the instance that processed all of it, within
+// kPrerollTolerance from that point on. This is what lets a file be
+// rendered in parallel chunks. The tolerance is derived for the FIR modes,
+// run the r8brain modes against the real library before relying on it.
+static constexpr double kPrerollTolerance = 1e-9;
+
+double prerollError(const Case& c)
+{
+	JSIF_DSP serial, chunk;
+	configure(serial, c);
+	configure(chunk, c);
+	const int32_t settle = chunk.getSettleSamples();
+	const int32_t first  = settle + 1000;           // not on a block boundary
+	const int32_t start  = first - settle;
+	const int32_t frames = first + kFrames;
+
+	std::vector<std::vector<double>> in(kChannels, std::vector<double>(frames));
+	for (int32_t ch = 0; ch < kChannels; ch++)
+	{
+		Noise noise(0x27D4EB2Fu + ch);
+		for (int32_t i = 0; i < frames; i++)
+			in[ch][i] = makeSample(c.signal, ch, i, kFrames, noise);
+	}
+	auto run = [&](JSIF_DSP& dsp, int32_t from) {
+		std::vector<std::vector<double>> io(kChannels);
+		for (int32_t ch = 0; ch < kChannels; ch++) io[ch].assign(in[ch].begin() + from, in[ch].end());
+		for (int32_t offset = 0; offset < frames - from; offset += kBlock)
+		{
+			double* ptr[kChannels];
+			for (int32_t ch = 0; ch < kChannels; ch++) ptr[ch] = io[ch].data() + offset;
+			dsp.process(ptr, ptr, kChannels, std::min(kBlock, frames - from - offset));
+		}
+		return io;
+	};
+	auto whole  = run(serial, 0);
+	auto rolled = run(chunk, start);
+
+	double err = 0.0;
+	for (int32_t ch = 0; ch < kChannels; ch++)
+		for (int32_t i = first; i < frames; i++)
+			err = std::max(err, std::abs(whole[ch][i] - rolled[ch][i - start]));
+	return err;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::string refPath = "jsif_golden.bin";
+	bool bounded = false, update = false, verbose = false, noLinear = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		if      (a == "--ref" && i + 1 < argc) refPath = argv[++i];
+		else if (a == "--bounded") bounded = true;
+		else if (a == "--update")  update  = true;
+		else if (a == "--verbose") verbose = true;
+		else if (a == "--no-r8b")  noLinear = true;
+		else if (a == "--low-footprint") lowFootprint = true;
+		else
+		{
+			fprintf(stderr, "usage: jsif_golden --ref FILE [--bounded] [--update] [--no-r8b] [--low-footprint] [--verbose]\n");
+			return 2;
+		}
+	}
+
+	std::map<std::string, Reference> refs;
+	bool haveFile = readGolden(refPath, refs);
+	if (!haveFile && !update)
+	{
+		fprintf(stderr, "jsif_golden: cannot read %s, run with --update to record it\n", refPath.c_str());
+		return 1;
+	}
+
+	std::vector<Case> cases;
+	for (const char* signal : kSignals)
+	for (int os : { 1, 2, 4, 8 })
+	for (bool linear : { false, true })
+	for (bool split : { false, true })
+	for (bool clip : { false, true })
+	{
+		if (os == 1 && linear) continue;
+		if (noLinear && linear) continue;
+		Case c;
+		c.signal = signal; c.os = os; c.linear = linear; c.split = split; c.clip = clip;
+		cases.push_back(c);
+	}
+
+	int failed = 0, passed = 0, skipped = 0;
+	auto fail = [&](const std::string& what) { fprintf(stderr, "FAIL %s\n", what.c_str()); failed++; };
+
+	bool anyLinear = false;
+	for (auto& c : cases)
+	{
+		std::string name = c.name();
+		auto out = render<double>(c, kBoundedFrames, kBoundedBlock);
+
+		if (update)
+		{
+			refs[name] = makeReference(render<double>(c), out);
+			continue;
+		}
+
+		auto it = refs.find(name);
+		if (it == refs.end())
+		{
+			if (verbose) printf("skip %s (no reference)\n", name.c_str());
+			skipped++;
+			continue;
+		}
+		anyLinear |= c.linear;
+
+		Tolerance tol = toleranceFor(c.os, c.linear);
+		double err = maxFrameError(it->second, out);
+		if (bounded)
+		{
+			if (err > tol.bounded) { char b[64]; snprintf(b, sizeof(b), " error %.3g > %.3g", err, tol.bounded); fail(name + b); continue; }
+		}
+		else if (err != 0.0 || hashOf(render<double>(c)) != it->second.hash)
+		{
+			fail(name + " differs from the reference (not bit-exact), max error " + std::to_string(err));
+			continue;
+		}
+
+		err = maxFrameError(it->second, render<float>(c, kBoundedFrames, kBoundedBlock));
+		if (err > tol.floatIO)
+		{
+			char b[64]; snprintf(b, sizeof(b), " float I/O error %.3g > %.3g", err, tol.floatIO);
+			fail(name + b);
+			continue;
+		}
+		if (verbose) printf("ok   %s\n", name.c_str());
+		passed++;
+	}
+
+	if (update)
+	{
+		if (!writeGolden(refPath, refs))
+		{
+			fprintf(stderr, "jsif_golden: cannot write %s\n", refPath.c_str());
+			return 1;
+		}
+		printf("jsif_golden: recorded %zu cases to %s\n", refs.size(), refPath.c_str());
+		return 0;
+	}
+
+	// latency, once per OS / Phase
+	for (int os : { 2, 4, 8 })
+	for (bool linear : { false, true })
+	{
+		Case c;
+		c.os = os; c.linear = linear;
+		std::string name = "latency/" + c.name().substr(1);
+		int32_t latency = expectedLatency(c);
+
+		int32_t dry = impulsePeak(c, 0.0);
+		if (dry != latency) { fail(name + " dry peak at " + std::to_string(dry) + ", getLatencySamples() " + std::to_string(latency)); continue; }
+
+		// the r8brain impulse is only meaningful where its references were recorded
+		if (linear && !anyLinear)
+		{
+			if (verbose) printf("skip %s wet peak (no r8b references)\n", name.c_str());
+			skipped++;
+			continue;
+		}
+		int32_t wet = impulsePeak(c, 1.0);
+		if (std::abs(wet - latency) > 1) { fail(name + " wet peak at " + std::to_string(wet) + ", getLatencySamples() " + std::to_string(latency)); continue; }
+
+		if (verbose) printf("ok   %s\n", name.c_str());
+		passed++;
+	}
+
+	// reset, once per OS / Phase with the band split on
+	for (int os : { 1, 2, 4, 8 })
+	for (bool linear : { false, true })
+	{
+		if ((os == 1 || noLinear) && linear) continue;
+		Case c;
+		c.signal = "noise"; c.os = os; c.linear = linear; c.split = true;
+		std::string name = "reset/" + c.name();
+		if (resetHash(c, noLinear) != hashOf(render<double>(c))) { fail(name + " differs from a freshly prepared instance"); continue; }
+		if (verbose) printf("ok   %s\n", name.c_str());
+		passed++;
+	}
+
+	// pre-roll, once per OS / Phase with and without the band split
+	for (int os : { 1, 2, 4, 8 })
+	for (bool linear : { false, true })
+	for (bool split : { false, true })
+	{
+		if ((os == 1 || noLinear) && linear) continue;
+		Case c;
+		c.signal = "noise"; c.os = os; c.linear = linear; c.split = split;
+		std::string name = "preroll/" + c.name();
+		double err = prerollError(c);
+		if (verbose) printf("     %s error %.3g\n", name.c_str(), err);
+		if (err > kPrerollTolerance) { char b[64]; snprintf(b, sizeof(b), " error %.3g > %.3g", err, kPrerollTolerance); fail(name + b); continue; }
+		if (verbose) printf("ok   %s\n", name.c_str());
+		passed++;
+	}
+
+	if (lowFootprint)
+	{
+		if (switchHash(true, noLinear) != switchHash(false, noLinear))
+			fail("switch/low-footprint differs from the default configuration");
+		else
+		{
+			if (verbose) printf("ok   switch/low-footprint\n");
+			passed++;
+		}
+	}
+
+	printf("jsif_golden: %d passed, %d failed, %d skipped (%s)\n", passed, failed, skipped, bounded ? "bounded" : "exact");
+	return failed ? 1 : 0;
+}
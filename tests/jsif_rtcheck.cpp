@@ -0,0 +1,317 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_rtcheck - real-time safety check for JSIF_DSP::process().
+//
+// Interposes the allocator (malloc family, operator new/delete), mutex and
+// condition variable waits and, with --syscalls, blocking system calls.
+// While a thread is inside process() any of them is a violation: it is
+// reported with a stack trace and the run fails.
+//
+// Every OS / Phase / Split / Clip / In / Bypass combination is processed
+// in float and double with several block sizes, followed by transitions of
+// every parameter between blocks. prepare() runs outside the checked scope.
+// The offline channel worker is not real-time safe by design and is not
+// enabled here.
+//
+// Needs glibc on Linux, elsewhere it exits with 77 (skipped).
+//
+//   jsif_rtcheck [--syscalls] [--abort] [--verbose]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define JSIF_RTCHECK_SUPPORTED 1
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <new>
+#endif
+
+namespace {
+
+thread_local bool        armed    = false;     // inside the checked scope
+thread_local const char* scope    = "";        // what is being processed
+bool                     syscalls = false;
+bool                     abortOnViolation = false;
+bool                     selfTest = false;     // count only, nothing is reported
+int                      violations = 0;
+
+#if JSIF_RTCHECK_SUPPORTED
+// Reports without allocating: the trace goes straight to stderr.
+void violation(const char* what)
+{
+	if (!armed)
+		return;
+	if (selfTest)
+	{
+		violations++;
+		return;
+	}
+	armed = false;
+
+	char line[256];
+	int len = snprintf(line, sizeof(line), "\nRT violation: %s during %s\n", what, scope);
+	if (write(STDERR_FILENO, line, (size_t)std::min<int>(len, sizeof(line) - 1)) < 0) {}
+
+	void* frames[64];
+	int depth = backtrace(frames, 64);
+	backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+
+	violations++;
+	if (abortOnViolation)
+		abort();
+	armed = true;
+}
+
+template <typename F>
+F next(const char* name)
+{
+	return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+#endif
+
+// Processing happens inside this scope only
+struct Checked
+{
+	explicit Checked(const char* what) { scope = what; armed = true; }
+	~Checked() { armed = false; }
+};
+
+} // namespace
+
+//------------------------------------------------------------------------
+// Interposers
+//------------------------------------------------------------------------
+#if JSIF_RTCHECK_SUPPORTED
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void  __libc_free(void*);
+
+void* malloc(size_t size)              { violation("malloc");  return __libc_malloc(size); }
+void* calloc(size_t n, size_t size)    { violation("calloc");  return __libc_calloc(n, size); }
+void* realloc(void* p, size_t size)    { violation("realloc"); return __libc_realloc(p, size); }
+void  free(void* p)                    { if (p) violation("free"); __libc_free(p); }
+void* memalign(size_t align, size_t size)      { violation("memalign");      return __libc_memalign(align, size); }
+void* aligned_alloc(size_t align, size_t size) { violation("aligned_alloc"); return __libc_memalign(align, size); }
+int   posix_memalign(void** out, size_t align, size_t size)
+{
+	violation("posix_memalign");
+	*out = __libc_memalign(align, size);
+	return *out ? 0 : 12; // ENOMEM
+}
+
+int pthread_mutex_lock(pthread_mutex_t* m)
+{
+	static auto real = next<int (*)(pthread_mutex_t*)>("pthread_mutex_lock");
+	violation("pthread_mutex_lock");
+	return real(m);
+}
+int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m)
+{
+	static auto real = next<int (*)(pthread_cond_t*, pthread_mutex_t*)>("pthread_cond_wait");
+	violation("pthread_cond_wait");
+	return real(c, m);
+}
+int pthread_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t)
+{
+	static auto real = next<int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)>("pthread_cond_timedwait");
+	violation("pthread_cond_timedwait");
+	return real(c, m, t);
+}
+
+// blocking system calls, only with --syscalls
+#define JSIF_RT_SYSCALL(ret, name, params, args)                           \
+ret name params                                                              \
+{                                                                            \
+	static auto real = next<ret (*) params>(#name);                          \
+	if (syscalls) violation(#name);                                          \
+	return real args;                                                        \
+}
+JSIF_RT_SYSCALL(ssize_t, read,      (int fd, void* buf, size_t n),        (fd, buf, n))
+JSIF_RT_SYSCALL(ssize_t, write,     (int fd, const void* buf, size_t n),  (fd, buf, n))
+JSIF_RT_SYSCALL(int,     usleep,    (useconds_t us),                      (us))
+JSIF_RT_SYSCALL(int,     nanosleep, (const struct timespec* a, struct timespec* b), (a, b))
+JSIF_RT_SYSCALL(int,     sched_yield, (void),                             ())
+#undef JSIF_RT_SYSCALL
+} // extern "C"
+
+void* operator new  (size_t size)                          { violation("operator new");    if (void* p = __libc_malloc(size ? size : 1)) return p; throw std::bad_alloc(); }
+void* operator new[](size_t size)                          { violation("operator new[]");  if (void* p = __libc_malloc(size ? size : 1)) return p; throw std::bad_alloc(); }
+void* operator new  (size_t size, const std::nothrow_t&) noexcept { violation("operator new");   return __libc_malloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { violation("operator new[]"); return __libc_malloc(size ? size : 1); }
+void* operator new  (size_t size, std::align_val_t a)      { violation("operator new");    if (void* p = __libc_memalign((size_t)a, size ? size : 1)) return p; throw std::bad_alloc(); }
+void* operator new[](size_t size, std::align_val_t a)      { violation("operator new[]");  if (void* p = __libc_memalign((size_t)a, size ? size : 1)) return p; throw std::bad_alloc(); }
+void  operator delete  (void* p) noexcept                  { if (p) violation("operator delete");   __libc_free(p); }
+void  operator delete[](void* p) noexcept                  { if (p) violation("operator delete[]"); __libc_free(p); }
+void  operator delete  (void* p, size_t) noexcept          { if (p) violation("operator delete");   __libc_free(p); }
+void  operator delete[](void* p, size_t) noexcept          { if (p) violation("operator delete[]"); __libc_free(p); }
+void  operator delete  (void* p, std::align_val_t) noexcept { if (p) violation("operator delete");   __libc_free(p); }
+void  operator delete[](void* p, std::align_val_t) noexcept { if (p) violation("operator delete[]"); __libc_free(p); }
+void  operator delete  (void* p, size_t, std::align_val_t) noexcept { if (p) violation("operator delete");   __libc_free(p); }
+void  operator delete[](void* p, size_t, std::align_val_t) noexcept { if (p) violation("operator delete[]"); __libc_free(p); }
+#endif
+
+//------------------------------------------------------------------------
+// Driver
+//------------------------------------------------------------------------
+using namespace yg331;
+
+namespace {
+
+static constexpr double  kSampleRate = 48000.0;
+static constexpr int32_t kChannels   = 2;
+static constexpr int32_t kMaxBlock   = 512;
+
+// buffers are allocated once, outside the checked scope
+template <typename SampleType>
+struct Buffers
+{
+	std::vector<std::vector<SampleType>> data;
+	std::vector<SampleType*> ptr;
+
+	Buffers() : data(kChannels, std::vector<SampleType>(kMaxBlock * 4)), ptr(kChannels)
+	{
+		for (int32_t ch = 0; ch < kChannels; ch++)
+		{
+			for (size_t i = 0; i < data[ch].size(); i++)
+				data[ch][i] = (SampleType)(0.8 * std::sin(0.01 * (double)i * (ch + 1)));
+			ptr[ch] = data[ch].data();
+		}
+	}
+};
+
+template <typename SampleType>
+void run(JSIF_DSP& dsp, Buffers<SampleType>& buffers, int32_t frames, const char* what)
+{
+	Checked checked(what);
+	dsp.process(buffers.ptr.data(), buffers.ptr.data(), kChannels, frames);
+	volatile double sink = dsp.getMeter() + dsp.getInputEnv(0) + dsp.getOutputEnv(1);
+	(void)sink;
+}
+
+template <typename SampleType>
+int checkModes(bool verbose)
+{
+	Buffers<SampleType> buffers;
+	const bool isDouble = sizeof(SampleType) == sizeof(double);
+	int cases = 0;
+
+	for (int os = 0; os <= 3; os++)
+	for (bool linear : { false, true })
+	for (bool split  : { false, true })
+	for (bool clip   : { false, true })
+	for (bool in     : { false, true })
+	for (bool bypass : { false, true })
+	{
+		if (os == 0 && linear) continue;
+
+		char what[160];
+		snprintf(what, sizeof(what), "%s x%d %s%s%s%s%s", isDouble ? "double" : "float", 1 << os,
+		         linear ? "r8b" : "fir", split ? " split" : "", clip ? " clip" : "", in ? "" : " out", bypass ? " bypass" : "");
+
+		JSIF_DSP dsp;
+		dsp.prepare(kSampleRate, kChannels, kMaxBlock);
+		dsp.setOverSample((overSample)os);
+		dsp.setLinearPhase(linear);
+		dsp.setSplit(split);
+		dsp.setClip(clip);
+		dsp.setIn(in);
+		dsp.setBypass(bypass);
+		dsp.setEffect(0.7);
+
+		// 1 frame, odd sizes, the prepared size and longer blocks that get split
+		for (int32_t frames : { 1, 7, 64, kMaxBlock, kMaxBlock * 3 + 5 })
+			run(dsp, buffers, frames, what);
+		cases++;
+		if (verbose) printf("ok   %s\n", what);
+	}
+	return cases;
+}
+
+// every parameter changes between blocks, including latency changing ones
+template <typename SampleType>
+int checkTransitions(bool verbose)
+{
+	Buffers<SampleType> buffers;
+	JSIF_DSP dsp;
+	dsp.prepare(kSampleRate, kChannels, kMaxBlock);
+	run(dsp, buffers, kMaxBlock, "warm up");
+
+	int steps = 0;
+	for (int round = 0; round < 4; round++)
+	{
+		for (int p = 0; p < JSIF_DSP::kNumParams; p++)
+		{
+			auto id = (JSIF_DSP::Param)p;
+			double value = dsp.getParam(id);
+			dsp.setParam(id, (id == JSIF_DSP::kOS) ? (double)((round + p) % 4) / 3.0 : 1.0 - value);
+			run(dsp, buffers, 64 + 37 * p, "parameter transition");
+			steps++;
+		}
+		dsp.reset();
+		run(dsp, buffers, kMaxBlock, "after reset");
+	}
+	if (verbose) printf("ok   %d parameter transitions (%s)\n", steps, sizeof(SampleType) == sizeof(double) ? "double" : "float");
+	return steps;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	bool verbose = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		if      (a == "--syscalls") syscalls = true;
+		else if (a == "--abort")    abortOnViolation = true;
+		else if (a == "--verbose")  verbose = true;
+		else
+		{
+			fprintf(stderr, "usage: jsif_rtcheck [--syscalls] [--abort] [--verbose]\n");
+			return 2;
+		}
+	}
+
+#if !JSIF_RTCHECK_SUPPORTED
+	fprintf(stderr, "jsif_rtcheck: interposition needs glibc on Linux, skipped\n");
+	return 77;
+#else
+	// backtrace() loads libgcc on first use, do it before anything is armed
+	void* warm[4];
+	backtrace(warm, 4);
+
+	// make sure the interposers are really in place
+	selfTest = true;
+	{
+		Checked checked("self test");
+		delete new volatile int(1);
+	}
+	selfTest = false;
+	if (violations != 2)
+	{
+		fprintf(stderr, "jsif_rtcheck: allocator interposition is not active (%d of 2 calls seen)\n", violations);
+		return 1;
+	}
+	violations = 0;
+
+	int cases = checkModes<float>(verbose) + checkModes<double>(verbose);
+	int steps = checkTransitions<float>(verbose) + checkTransitions<double>(verbose);
+
+	printf("jsif_rtcheck: %d modes, %d transitions, %d violations%s\n", cases, steps, violations,
+	       syscalls ? " (with syscalls)" : "");
+	return violations ? 1 : 0;
+#endif
+}
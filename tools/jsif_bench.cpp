@@ -0,0 +1,403 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_bench - throughput of the JSIF_DSP signal path.
+//
+// Measures ns/sample and samples/second of every pipeline stage and of the
+// full chain across oversampling, phase, split, clip, sample precision,
+// channel count and block size. Results are written as JSON, all figures
+// are per channel sample at the base rate, also for the oversampled stages.
+// On Linux each row also carries hardware counters (cycles, instructions,
+// IPC, L1D/LLC misses, branch misses) when perf_event_open is permitted,
+// otherwise "counters" is null.
+//
+//   jsif_bench [--quick] [--out file.json] [--min-time seconds]
+//              [--os 1,2,4,8] [--phase fir,r8b] [--split 0,1] [--clip 0,1]
+//              [--precision float,double] [--channels 1,2,8]
+//              [--blocks 16,32,...,8192] [--no-stages] [--no-chain]
+//              [--no-counters]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_tool_utils.h"
+#include "jsif_perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+struct Config
+{
+	int    os        = 1;      // 1, 2, 4, 8
+	bool   linear    = false;  // r8brain linear phase instead of FIR
+	bool   split     = false;
+	bool   clip      = false;
+	bool   isDouble  = false;
+	int    channels  = 2;
+	int    block     = 512;
+};
+
+struct Result
+{
+	double seconds = 0.0;      // median of the repetitions
+	double bestSeconds = 0.0;  // fastest repetition
+	long long samples = 0;     // channel samples per repetition
+
+	PerfCounters::Values counters;  // summed over all timed repetitions
+	double countedSamples = 0.0;    // channel samples covered by counters
+};
+
+struct Options
+{
+	std::vector<int>  os         = { 1, 2, 4, 8 };
+	std::vector<bool> linear     = { false, true };
+	std::vector<bool> split      = { false, true };
+	std::vector<bool> clip       = { false, true };
+	std::vector<bool> isDouble   = { false, true };
+	std::vector<int>  channels   = { 1, 2, 8 };
+	std::vector<int>  blocks     = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+	double            minTime    = 0.02;
+	int               reps       = 5;
+	double            sampleRate = 48000.0;
+	bool              stages     = true;
+	bool              chain      = true;
+	std::string       out;
+	PerfCounters*     counters   = nullptr;
+};
+
+//------------------------------------------------------------------------
+// Exposes the per sample stages of JSIF_DSP so they can be timed alone.
+class StageProbe : public JSIF_DSP
+{
+public:
+	void upsample(const double* in, double* up, int32_t frames, int32_t channel, int32_t os)
+	{
+		for (int32_t i = 0; i < frames; i++)
+			upsampleStage(in[i], up + i * os, channel, os);
+	}
+	void shape(const double* up, double* shaped, int32_t frames, int32_t channel, int32_t os)
+	{
+		for (int32_t i = 0; i < frames; i++)
+			shapeStage(up + i * os, shaped + i * os, channel, os);
+	}
+	void downsample(double* shaped, double* out, int32_t frames, int32_t channel, int32_t os)
+	{
+		for (int32_t i = 0; i < frames; i++)
+			out[i] = downsampleStage(shaped + i * os, channel, os);
+	}
+	void meter(double** channels, int32_t numChannels, int32_t frames)
+	{
+		VuInput.update(channels, numChannels, frames);
+	}
+};
+
+void configure(JSIF_DSP& dsp, const Config& c, double sampleRate)
+{
+	dsp.prepare(sampleRate, c.channels, c.block);
+	dsp.setInput(0.5);
+	dsp.setEffect(1.0);
+	dsp.setCurve(0.5);
+	dsp.setOutput(1.0);
+	dsp.setOverSample(toOverSample(c.os));
+	dsp.setLinearPhase(c.linear);
+	dsp.setSplit(c.split);
+	dsp.setClip(c.clip);
+	dsp.setIn(true);
+	dsp.setBypass(false);
+}
+
+// Runs `body` (which processes `samples` channel samples) until minTime is
+// spent per repetition, returns the median and best seconds per call.
+template <typename Body>
+Result measure(const Options& opt, long long samples, Body&& body)
+{
+	using clock = std::chrono::steady_clock;
+
+	// warm up caches and r8brain's internal buffers
+	body();
+
+	// calibrate iterations so one repetition lasts about minTime / reps
+	long long iterations = 1;
+	double perRep = opt.minTime / (double)opt.reps;
+	while (true)
+	{
+		auto start = clock::now();
+		for (long long i = 0; i < iterations; i++) body();
+		double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		if (elapsed >= perRep || iterations >= (1LL << 30)) break;
+		iterations *= (elapsed > 0.0) ? std::max(2LL, (long long)(perRep / elapsed) + 1) : 2;
+	}
+
+	Result result;
+	if (opt.counters) opt.counters->start();
+
+	std::vector<double> times;
+	for (int r = 0; r < opt.reps; r++)
+	{
+		auto start = clock::now();
+		for (long long i = 0; i < iterations; i++) body();
+		times.push_back(std::chrono::duration<double>(clock::now() - start).count() / (double)iterations);
+	}
+	std::sort(times.begin(), times.end());
+
+	if (opt.counters)
+	{
+		result.counters       = opt.counters->stop();
+		result.countedSamples = (double)samples * (double)iterations * (double)opt.reps;
+	}
+
+	result.seconds     = times[times.size() / 2];
+	result.bestSeconds = times.front();
+	result.samples     = samples;
+	return result;
+}
+
+//------------------------------------------------------------------------
+// Minimal JSON writer, one object per line inside "results".
+class JsonOut
+{
+public:
+	explicit JsonOut(FILE* f) : file(f) {}
+
+	void begin(const Options& opt)
+	{
+		fprintf(file, "{\n  \"tool\": \"jsif_bench\",\n  \"sample_rate\": %.1f,\n  \"min_time\": %g,\n  \"reps\": %d,\n  \"counters_available\": %s,\n  \"results\": [\n",
+		        opt.sampleRate, opt.minTime, opt.reps, (opt.counters && opt.counters->available()) ? "true" : "false");
+	}
+
+	void row(const char* stage, const Config& c, const Result& r, double sampleRate)
+	{
+		double nsPerSample   = 1e9 * r.seconds / (double)r.samples;
+		double samplesPerSec = (double)r.samples / r.seconds;
+		// realtime factor of the whole c.channels stream: frames per second over the rate
+		double realtime      = samplesPerSec / (double)c.channels / sampleRate;
+
+		fprintf(file, "%s    {\"stage\": \"%s\", \"os\": %d, \"phase\": \"%s\", \"split\": %s, \"clip\": %s, "
+		              "\"precision\": \"%s\", \"channels\": %d, \"block\": %d, "
+		              "\"ns_per_sample\": %.4f, \"ns_per_sample_best\": %.4f, \"samples_per_second\": %.1f, \"realtime_x\": %.2f, ",
+		        first ? "" : ",\n", stage, c.os, c.linear ? "r8b" : "fir",
+		        c.split ? "true" : "false", c.clip ? "true" : "false",
+		        c.isDouble ? "double" : "float", c.channels, c.block,
+		        nsPerSample, 1e9 * r.bestSeconds / (double)r.samples, samplesPerSec, realtime);
+		counters(r);
+		fprintf(file, "}");
+		fflush(file);
+		first = false;
+	}
+
+	void end() { fprintf(file, "\n  ]\n}\n"); }
+
+private:
+	// counts are per channel sample, missing counters are null
+	void counters(const Result& r)
+	{
+		if (!r.counters.any() || r.countedSamples <= 0.0)
+		{
+			fprintf(file, "\"counters\": null");
+			return;
+		}
+		fprintf(file, "\"counters\": {");
+		for (int i = 0; i < PerfCounters::kNumCounters; i++)
+		{
+			if (r.counters.valid[i])
+				fprintf(file, "\"%s_per_sample\": %.4f, ", PerfCounters::name(i), r.counters.count[i] / r.countedSamples);
+			else
+				fprintf(file, "\"%s_per_sample\": null, ", PerfCounters::name(i));
+		}
+		double ipc = r.counters.ipc();
+		if (ipc >= 0.0) fprintf(file, "\"ipc\": %.3f}", ipc);
+		else            fprintf(file, "\"ipc\": null}");
+	}
+
+	FILE* file;
+	bool first = true;
+};
+
+//------------------------------------------------------------------------
+template <typename SampleType>
+Result benchChain(const Options& opt, const Config& c)
+{
+	JSIF_DSP dsp;
+	configure(dsp, c, opt.sampleRate);
+
+	std::vector<std::vector<SampleType>> in (c.channels, std::vector<SampleType>(c.block));
+	std::vector<std::vector<SampleType>> out(c.channels, std::vector<SampleType>(c.block));
+	fillSignal(in, opt.sampleRate);
+
+	std::vector<SampleType*> inPtr, outPtr;
+	for (int ch = 0; ch < c.channels; ch++) { inPtr.push_back(in[ch].data()); outPtr.push_back(out[ch].data()); }
+
+	return measure(opt, (long long)c.block * c.channels, [&] {
+		dsp.process(inPtr.data(), outPtr.data(), c.channels, c.block);
+	});
+}
+
+void benchStages(const Options& opt, const Config& c, JsonOut& json)
+{
+	StageProbe dsp;
+	configure(dsp, c, opt.sampleRate);
+
+	const int32_t frames = c.block;
+	const int32_t os     = c.os;
+
+	std::vector<std::vector<double>> in(1, std::vector<double>(frames));
+	fillSignal(in, opt.sampleRate);
+	std::vector<double> up(frames * os), shaped(frames * os), out(frames);
+
+	// one pass through the chain sets the curve and band split coefficients
+	{
+		std::vector<double> scratch(in[0]);
+		double* ptr[1] = { scratch.data() };
+		dsp.process(ptr, ptr, 1, frames);
+	}
+
+	json.row("upsample", c, measure(opt, frames, [&] {
+		dsp.upsample(in[0].data(), up.data(), frames, 0, os);
+	}), opt.sampleRate);
+
+	json.row("shape", c, measure(opt, frames, [&] {
+		dsp.shape(up.data(), shaped.data(), frames, 0, os);
+	}), opt.sampleRate);
+
+	json.row("downsample", c, measure(opt, frames, [&] {
+		dsp.downsample(shaped.data(), out.data(), frames, 0, os);
+	}), opt.sampleRate);
+
+	double* meterPtr[1] = { in[0].data() };
+	json.row("meter", c, measure(opt, frames, [&] {
+		dsp.meter(meterPtr, 1, frames);
+	}), opt.sampleRate);
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_bench [options]\n"
+		"  --out FILE            write JSON to FILE instead of stdout\n"
+		"  --quick               reduced matrix for a fast sanity run\n"
+		"  --min-time S          seconds spent per measurement (default 0.02)\n"
+		"  --reps N              repetitions per measurement, median is reported (default 5)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --os LIST             oversampling factors, e.g. 1,2,4,8\n"
+		"  --phase LIST          fir,r8b\n"
+		"  --split LIST          0,1\n"
+		"  --clip LIST           0,1\n"
+		"  --precision LIST      float,double\n"
+		"  --channels LIST       e.g. 1,2,8\n"
+		"  --blocks LIST         e.g. 16,64,512,8192\n"
+		"  --no-stages           skip the per stage measurements\n"
+		"  --no-chain            skip the full chain measurements\n"
+		"  --no-counters         do not read hardware performance counters\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt, bool& useCounters)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--quick") {
+			opt.split = { false }; opt.clip = { false }; opt.isDouble = { false };
+			opt.channels = { 2 }; opt.blocks = { 64, 512, 4096 };
+		}
+		else if (a == "--no-stages") opt.stages = false;
+		else if (a == "--no-chain")  opt.chain  = false;
+		else if (a == "--no-counters") useCounters = false;
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")       opt.out = v;
+		else if (a == "--min-time")  opt.minTime = atof(v);
+		else if (a == "--reps")      opt.reps = std::max(1, atoi(v));
+		else if (a == "--rate")      opt.sampleRate = atof(v);
+		else if (a == "--os")        opt.os = intList(v);
+		else if (a == "--phase")     opt.linear = boolList(v, "r8b");
+		else if (a == "--split")     opt.split = boolList(v, "split");
+		else if (a == "--clip")      opt.clip = boolList(v, "clip");
+		else if (a == "--precision") opt.isDouble = boolList(v, "double");
+		else if (a == "--channels")  opt.channels = intList(v);
+		else if (a == "--blocks")    opt.blocks = intList(v);
+		else { usage(); return false; }
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	bool useCounters = true;
+	if (!parse(argc, argv, opt, useCounters))
+		return 1;
+
+	PerfCounters counters;
+	if (useCounters)
+	{
+		if (counters.available())
+			opt.counters = &counters;
+		else
+			fprintf(stderr, "jsif_bench: hardware counters unavailable, reporting wall clock only\n");
+	}
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_bench: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+
+	JsonOut json(file);
+	json.begin(opt);
+
+	for (int os : opt.os)
+	for (bool linear : opt.linear)
+	{
+		// 1x has no oversampler, phase makes no difference
+		if (os == 1 && linear && opt.linear.size() > 1) continue;
+
+		for (bool split : opt.split)
+		for (bool clip : opt.clip)
+		{
+			Config c;
+			c.os = os; c.linear = linear; c.split = split; c.clip = clip;
+
+			// stages run per sample, one block size and channel is enough
+			if (opt.stages)
+			{
+				c.channels = 1;
+				c.block    = 512;
+				c.isDouble = true;
+				benchStages(opt, c, json);
+			}
+
+			if (!opt.chain) continue;
+
+			for (bool isDouble : opt.isDouble)
+			for (int channels : opt.channels)
+			for (int block : opt.blocks)
+			{
+				c.isDouble = isDouble; c.channels = channels; c.block = block;
+				Result r = isDouble ? benchChain<double>(opt, c) : benchChain<float>(opt, c);
+				json.row("chain", c, r, opt.sampleRate);
+			}
+		}
+	}
+
+	json.end();
+	if (file != stdout) fclose(file);
+	return 0;
+}
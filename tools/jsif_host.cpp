@@ -0,0 +1,745 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_host - headless VST3 host for end to end profiling.
+//
+// Loads the built module through its real entry point and runs it the way
+// a DAW does: initialize, connect component and controller, setupProcessing,
+// setActive, setProcessing and a process() loop over synthetic audio. No GUI,
+// no audio device. Every automatable parameter of the plug-in is automated
+// through IParameterChanges: continuous ones follow slow sines every block,
+// list parameters (OS, Phase, ...) step every --switch-ms. Output parameter
+// changes are handed to the controller between blocks, the controller's
+// messages travel through the SDK's connection proxy as in a host, and
+// restartComponent(kLatencyChanged) is answered with getLatencySamples().
+//
+// Each process() call is timed, the summary per block size is JSON.
+//
+// --lifecycle N instead creates N instances side by side per sample rate
+// and times what scans and template loads do: construction, initialize,
+// the controller, setupProcessing, setActive and terminate, plus the
+// resident memory per instance.
+//
+// --latency-check restores an x8 state into a fresh instance, then steps
+// OS to x1, x8 and x1. After every block the controller has to hold the
+// processor's latency, and every change, the one back to 0 included, has
+// to reach the host through restartComponent(kLatencyChanged). Exits 1
+// otherwise, ctest runs it.
+//
+//   jsif_host MODULE.vst3 [--out file.json] [--blocks 32,512] [--rate HZ]
+//             [--seconds S] [--precision float|double] [--offline]
+//             [--switch-ms MS] [--no-automation]
+//   jsif_host MODULE.vst3 --lifecycle N [--rates 44100,48000,96000,192000]
+//   jsif_host MODULE.vst3 --latency-check
+//------------------------------------------------------------------------
+
+#include "public.sdk/source/common/memorystream.h"
+#include "public.sdk/source/vst/hosting/hostclasses.h"
+#include "public.sdk/source/vst/hosting/module.h"
+#include "public.sdk/source/vst/hosting/parameterchanges.h"
+#include "public.sdk/source/vst/hosting/plugprovider.h"
+#include "public.sdk/source/vst/hosting/processdata.h"
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include "pluginterfaces/vst/ivstcomponent.h"
+#include "pluginterfaces/vst/ivsteditcontroller.h"
+
+#include "JSIF_cids.h"
+#include "JSIF_dsp.h"
+#include "jsif_memory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Steinberg;
+
+namespace {
+
+//------------------------------------------------------------------------
+struct Options
+{
+	std::string      module;
+	std::string      out;
+	std::vector<int> blocks       = { 32, 128, 512, 2048 };
+	double           sampleRate   = 48000.0;
+	double           seconds      = 5.0;
+	bool             isDouble     = false;
+	bool             offline      = false;
+	bool             automation   = true;
+	double           switchMs     = 250.0;
+	int              lifecycle    = 0;  // instances, 0 = process loop
+	bool             latencyCheck = false;
+	std::vector<int> rates        = { 44100, 48000, 96000, 192000 };
+};
+
+struct Stats
+{
+	long long calls = 0;
+	double mean = 0.0, p50 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;  // ns
+	long long inputPoints   = 0;  // IParameterChanges points sent to process()
+	long long outputPoints  = 0;  // points the processor sent back
+	long long latencyChanges = 0;
+	double controllerNs = 0.0;    // time spent handing output changes to the controller
+};
+
+//------------------------------------------------------------------------
+// Counts restartComponent() calls, everything else is accepted and ignored.
+class HostHandler : public Vst::IComponentHandler
+{
+public:
+	tresult PLUGIN_API beginEdit(Vst::ParamID) SMTG_OVERRIDE { return kResultOk; }
+	tresult PLUGIN_API performEdit(Vst::ParamID, Vst::ParamValue) SMTG_OVERRIDE { return kResultOk; }
+	tresult PLUGIN_API endEdit(Vst::ParamID) SMTG_OVERRIDE { return kResultOk; }
+	tresult PLUGIN_API restartComponent(int32 flags) SMTG_OVERRIDE
+	{
+		if (flags & Vst::kLatencyChanged) latencyChanged = true;
+		return kResultOk;
+	}
+
+	tresult PLUGIN_API queryInterface(const TUID _iid, void** obj) SMTG_OVERRIDE
+	{
+		QUERY_INTERFACE(_iid, obj, FUnknown::iid, Vst::IComponentHandler)
+		QUERY_INTERFACE(_iid, obj, Vst::IComponentHandler::iid, Vst::IComponentHandler)
+		*obj = nullptr;
+		return kNoInterface;
+	}
+	// lives on the stack of main() for the whole run
+	uint32 PLUGIN_API addRef() SMTG_OVERRIDE { return 1000; }
+	uint32 PLUGIN_API release() SMTG_OVERRIDE { return 1000; }
+
+	bool latencyChanged = false;
+};
+
+//------------------------------------------------------------------------
+struct AutomatedParam
+{
+	Vst::ParamID id;
+	int32 stepCount;    // 0 = continuous
+	double rate;        // Hz of the sine for continuous parameters
+	double start;
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0.0;
+	size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+	return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+template <typename SampleType>
+SampleType** channelBuffers(Vst::AudioBusBuffers& bus);
+template <>
+Vst::Sample32** channelBuffers<Vst::Sample32>(Vst::AudioBusBuffers& bus) { return bus.channelBuffers32; }
+template <>
+Vst::Sample64** channelBuffers<Vst::Sample64>(Vst::AudioBusBuffers& bus) { return bus.channelBuffers64; }
+
+// 440 Hz sine over a slow noise bed, loud enough to drive the curve
+template <typename SampleType>
+void fillBlock(Vst::HostProcessData& data, int32 frames, long long position, double sampleRate, uint32& seed)
+{
+	for (int32 bus = 0; bus < data.numInputs; bus++)
+	{
+		SampleType** buffers = channelBuffers<SampleType>(data.inputs[bus]);
+		for (int32 ch = 0; ch < data.inputs[bus].numChannels; ch++)
+		{
+			for (int32 i = 0; i < frames; i++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				double noise = ((double)(seed >> 8) / (double)(1u << 24)) * 2.0 - 1.0;
+				double sine  = 0.5 * std::sin(2.0 * M_PI * 440.0 * (double)(position + i) / sampleRate);
+				buffers[ch][i] = (SampleType)(sine + 0.3 * noise);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+class Session
+{
+public:
+	Session(Vst::IComponent* component, Vst::IAudioProcessor* processor, Vst::IEditController* controller,
+	        HostHandler& handler, const Options& opt)
+		: component(component), processor(processor), controller(controller), handler(handler), opt(opt)
+	{
+		if (!opt.automation || !controller)
+			return;
+		int32 count = controller->getParameterCount();
+		for (int32 i = 0; i < count; i++)
+		{
+			Vst::ParameterInfo info {};
+			if (controller->getParameterInfo(i, info) != kResultOk) continue;
+			if (!(info.flags & Vst::ParameterInfo::kCanAutomate)) continue;
+			if (info.flags & (Vst::ParameterInfo::kIsBypass | Vst::ParameterInfo::kIsReadOnly)) continue;
+			double n = (double)automated.size();
+			automated.push_back({ info.id, info.stepCount, 0.1 + 0.07 * n, info.defaultNormalizedValue });
+		}
+	}
+
+	bool setup(int32 block)
+	{
+		Vst::ProcessSetup setup {};
+		setup.processMode        = opt.offline ? Vst::kOffline : Vst::kRealtime;
+		setup.symbolicSampleSize = opt.isDouble ? Vst::kSample64 : Vst::kSample32;
+		setup.maxSamplesPerBlock = block;
+		setup.sampleRate         = opt.sampleRate;
+
+		if (processor->canProcessSampleSize(setup.symbolicSampleSize) != kResultTrue)
+		{
+			fprintf(stderr, "jsif_host: module does not process %s samples\n", opt.isDouble ? "double" : "float");
+			return false;
+		}
+		if (processor->setupProcessing(setup) != kResultOk)
+		{
+			fprintf(stderr, "jsif_host: setupProcessing failed\n");
+			return false;
+		}
+		for (int32 dir : { Vst::kInput, Vst::kOutput })
+			for (int32 i = 0; i < component->getBusCount(Vst::kAudio, dir); i++)
+				component->activateBus(Vst::kAudio, dir, i, true);
+
+		if (!data.prepare(*component, block, setup.symbolicSampleSize))
+		{
+			fprintf(stderr, "jsif_host: cannot allocate process buffers\n");
+			return false;
+		}
+		component->setActive(true);
+		processor->setProcessing(true);
+		return true;
+	}
+
+	void teardown()
+	{
+		processor->setProcessing(false);
+		component->setActive(false);
+		data.unprepare();
+	}
+
+	Stats run(int32 block)
+	{
+		Stats stats;
+		inputChanges.setMaxParameters((int32)automated.size());
+		outputChanges.setMaxParameters(64);
+
+		const long long calls = std::max<long long>(100, (long long)(opt.seconds * opt.sampleRate / block));
+		const long long switchEvery = std::max<long long>(1, (long long)(opt.switchMs * 1e-3 * opt.sampleRate / block));
+
+		std::vector<double> times;
+		times.reserve((size_t)calls);
+		uint32 seed = 331;
+
+		for (long long call = 0; call < calls; call++)
+		{
+			long long position = call * block;
+			if (opt.isDouble) fillBlock<Vst::Sample64>(data, block, position, opt.sampleRate, seed);
+			else              fillBlock<Vst::Sample32>(data, block, position, opt.sampleRate, seed);
+
+			inputChanges.clearQueue();
+			outputChanges.clearQueue();
+			if (!automated.empty())
+				stats.inputPoints += automate(call, position, switchEvery);
+
+			data.numSamples             = block;
+			data.inputParameterChanges  = &inputChanges;
+			data.outputParameterChanges = &outputChanges;
+
+			auto start = std::chrono::steady_clock::now();
+			processor->process(data);
+			times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+
+			// between blocks, as a host's UI thread would
+			auto handOver = std::chrono::steady_clock::now();
+			stats.outputPoints += deliverOutputChanges();
+			if (handler.latencyChanged)
+			{
+				handler.latencyChanged = false;
+				processor->getLatencySamples();
+				stats.latencyChanges++;
+			}
+			stats.controllerNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - handOver).count();
+		}
+
+		stats.calls = (long long)times.size();
+		double sum = 0.0;
+		for (double t : times) sum += t;
+		stats.mean = sum / (double)times.size();
+		std::sort(times.begin(), times.end());
+		stats.p50  = percentile(times, 0.50);
+		stats.p99  = percentile(times, 0.99);
+		stats.p999 = percentile(times, 0.999);
+		stats.max  = times.back();
+		return stats;
+	}
+
+	// one block with an optional parameter change, true if it brought a latency restart
+	bool step(int32 block, Vst::ParamID id, Vst::ParamValue value)
+	{
+		inputChanges.setMaxParameters(1);
+		outputChanges.setMaxParameters(64);
+		inputChanges.clearQueue();
+		outputChanges.clearQueue();
+
+		uint32 seed = 331;
+		if (opt.isDouble) fillBlock<Vst::Sample64>(data, block, 0, opt.sampleRate, seed);
+		else              fillBlock<Vst::Sample32>(data, block, 0, opt.sampleRate, seed);
+
+		if (id != Vst::kNoParamId)
+		{
+			int32 index = 0;
+			if (Vst::IParamValueQueue* queue = inputChanges.addParameterData(id, index))
+				queue->addPoint(0, value, index);
+			controller->setParamNormalized(id, value);
+		}
+
+		data.numSamples             = block;
+		data.inputParameterChanges  = &inputChanges;
+		data.outputParameterChanges = &outputChanges;
+		processor->process(data);
+		deliverOutputChanges();
+
+		bool restarted = handler.latencyChanged;
+		handler.latencyChanged = false;
+		return restarted;
+	}
+
+private:
+	// queues one point per automated parameter, mirrored to the controller like a host does
+	int32 automate(long long call, long long position, long long switchEvery)
+	{
+		int32 points = 0;
+		double time = (double)position / opt.sampleRate;
+		for (auto& p : automated)
+		{
+			double value;
+			if (p.stepCount == 0)
+				value = 0.5 + 0.5 * std::sin(2.0 * M_PI * p.rate * time + p.start * 2.0 * M_PI);
+			else if (call % switchEvery == 0)
+				value = (double)((call / switchEvery + (long long)p.id) % (p.stepCount + 1)) / (double)p.stepCount;
+			else
+				continue;
+
+			int32 index = 0;
+			if (Vst::IParamValueQueue* queue = inputChanges.addParameterData(p.id, index))
+			{
+				queue->addPoint(0, value, index);
+				points++;
+			}
+			controller->setParamNormalized(p.id, value);
+		}
+		return points;
+	}
+
+	int32 deliverOutputChanges()
+	{
+		if (!controller) return 0;
+		int32 points = 0;
+		for (int32 i = 0; i < outputChanges.getParameterCount(); i++)
+		{
+			Vst::IParamValueQueue* queue = outputChanges.getParameterData(i);
+			if (!queue || queue->getPointCount() <= 0) continue;
+			int32 offset = 0;
+			Vst::ParamValue value = 0.0;
+			if (queue->getPoint(queue->getPointCount() - 1, offset, value) == kResultTrue)
+				controller->setParamNormalized(queue->getParameterId(), value);
+			points += queue->getPointCount();
+		}
+		return points;
+	}
+
+	Vst::IComponent*      component;
+	Vst::IAudioProcessor* processor;
+	Vst::IEditController* controller;
+	HostHandler&          handler;
+	const Options&        opt;
+
+	Vst::HostProcessData   data;
+	Vst::ParameterChanges  inputChanges;
+	Vst::ParameterChanges  outputChanges;
+	std::vector<AutomatedParam> automated;
+};
+
+//------------------------------------------------------------------------
+// Instance creation as in a plug-in scan or template load, per sample rate
+enum LifecyclePhase { kCreate = 0, kInitialize, kController, kSetup, kActivate, kTerminate, kNumLifecyclePhases };
+
+const char* lifecyclePhaseName(int p)
+{
+	static const char* names[kNumLifecyclePhases] = { "create", "initialize", "controller", "setup", "activate", "terminate" };
+	return names[p];
+}
+
+int runLifecycle(const VST3::Hosting::PluginFactory& factory, const VST3::Hosting::ClassInfo& classInfo,
+                 FUnknown* hostContext, const Options& opt, FILE* file)
+{
+	using clock = std::chrono::steady_clock;
+	auto ms = [](clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	};
+
+	struct Instance
+	{
+		IPtr<Vst::IComponent> component;
+		IPtr<Vst::IEditController> controller;
+	};
+
+	fprintf(file, "{\n  \"tool\": \"jsif_host\",\n  \"module\": \"%s\",\n  \"instances\": %d,\n  \"lifecycle\": [",
+	        opt.module.c_str(), opt.lifecycle);
+
+	int result = 0;
+	bool first = true;
+	for (int rate : opt.rates)
+	{
+		if (rate <= 0) continue;
+		std::vector<double> times[kNumLifecyclePhases];
+		std::vector<Instance> instances(opt.lifecycle);
+
+		uint64_t residentBefore = residentBytes();
+		for (auto& inst : instances)
+		{
+			auto start = clock::now();
+			inst.component = factory.createInstance<Vst::IComponent>(classInfo.ID());
+			times[kCreate].push_back(ms(start));
+			if (!inst.component) { result = 1; break; }
+
+			start = clock::now();
+			inst.component->initialize(hostContext);
+			times[kInitialize].push_back(ms(start));
+
+			// a separate controller class, unless the component is its own controller
+			start = clock::now();
+			TUID controllerCID;
+			if (inst.component->getControllerClassId(controllerCID) == kResultTrue)
+			{
+				inst.controller = factory.createInstance<Vst::IEditController>(VST3::UID::fromTUID(controllerCID));
+				if (inst.controller)
+					inst.controller->initialize(hostContext);
+			}
+			times[kController].push_back(ms(start));
+
+			FUnknownPtr<Vst::IAudioProcessor> processor(inst.component);
+			if (!processor) { result = 1; break; }
+			Vst::ProcessSetup setup {};
+			setup.processMode        = Vst::kRealtime;
+			setup.symbolicSampleSize = Vst::kSample32;
+			setup.maxSamplesPerBlock = 1024;
+			setup.sampleRate         = (double)rate;
+
+			start = clock::now();
+			processor->setupProcessing(setup);
+			times[kSetup].push_back(ms(start));
+
+			start = clock::now();
+			inst.component->setActive(true);
+			times[kActivate].push_back(ms(start));
+		}
+		uint64_t residentAfter = residentBytes();
+
+		for (auto& inst : instances)
+		{
+			auto start = clock::now();
+			if (inst.component)
+			{
+				inst.component->setActive(false);
+				inst.component->terminate();
+			}
+			if (inst.controller)
+				inst.controller->terminate();
+			inst.component  = nullptr;
+			inst.controller = nullptr;
+			times[kTerminate].push_back(ms(start));
+		}
+		if (result != 0)
+		{
+			fprintf(stderr, "jsif_host: cannot create an instance of %s\n", classInfo.name().c_str());
+			break;
+		}
+
+		double residentKb = (residentAfter > residentBefore)
+			? (double)(residentAfter - residentBefore) / 1024.0 / (double)opt.lifecycle : 0.0;
+		fprintf(file, "%s\n    {\"rate\": %d, \"resident_kb\": %.1f", first ? "" : ",", rate, residentKb);
+		for (int p = 0; p < kNumLifecyclePhases; p++)
+		{
+			std::vector<double>& t = times[p];
+			std::sort(t.begin(), t.end());
+			fprintf(file, ", \"%s_median_ms\": %.4f, \"%s_max_ms\": %.4f",
+			        lifecyclePhaseName(p), t.empty() ? 0.0 : t[t.size() / 2],
+			        lifecyclePhaseName(p), t.empty() ? 0.0 : t.back());
+		}
+		fprintf(file, "}");
+		first = false;
+	}
+	fprintf(file, "\n  ]\n}\n");
+	return result;
+}
+
+//------------------------------------------------------------------------
+// Component and controller through PlugProvider, connected as in main()
+struct Instance
+{
+	IPtr<Vst::PlugProvider>    provider;
+	IPtr<Vst::IComponent>      component;
+	IPtr<Vst::IEditController> controller;
+};
+
+bool openInstance(const VST3::Hosting::PluginFactory& factory, const VST3::Hosting::ClassInfo& classInfo, Instance& inst)
+{
+	inst.provider = owned(new Vst::PlugProvider(factory, classInfo, true));
+	if (!inst.provider->initialize())
+	{
+		fprintf(stderr, "jsif_host: cannot create %s\n", classInfo.name().c_str());
+		return false;
+	}
+	inst.component  = inst.provider->getComponentPtr();
+	inst.controller = inst.provider->getControllerPtr();
+	if (!inst.controller || !FUnknownPtr<Vst::IAudioProcessor>(inst.component))
+	{
+		fprintf(stderr, "jsif_host: %s has no controller or no IAudioProcessor\n", classInfo.name().c_str());
+		return false;
+	}
+	return true;
+}
+
+int runLatencyCheck(const VST3::Hosting::PluginFactory& factory, const VST3::Hosting::ClassInfo& classInfo,
+                    const Options& opt, FILE* file)
+{
+	const int32 block = 512;
+	const Vst::ParamValue x1 = 0.0, x8 = 1.0;  // ends of the OS list
+	IPtr<MemoryStream> state = owned(new MemoryStream());
+
+	// an instance left at x8 FIR, saved as a project would be
+	{
+		HostHandler handler;  // outlives the controller that references it
+		Instance saved;
+		if (!openInstance(factory, classInfo, saved)) return 1;
+		FUnknownPtr<Vst::IAudioProcessor> processor(saved.component);
+		saved.controller->setComponentHandler(&handler);
+
+		Session session(saved.component, processor, saved.controller, handler, opt);
+		if (!session.setup(block)) return 1;
+		session.step(block, yg331::kParamPhase, 0.0);
+		session.step(block, yg331::kParamOS, x8);
+		session.teardown();
+		saved.component->getState(state);
+		saved.controller->setComponentHandler(nullptr);
+	}
+
+	// restored into a fresh instance, then the OS list is stepped
+	HostHandler handler;
+	Instance inst;
+	if (!openInstance(factory, classInfo, inst)) return 1;
+	FUnknownPtr<Vst::IAudioProcessor> processor(inst.component);
+	inst.controller->setComponentHandler(&handler);
+
+	state->seek(0, IBStream::kIBSeekSet, nullptr);
+	inst.component->setState(state);
+	state->seek(0, IBStream::kIBSeekSet, nullptr);
+	inst.controller->setComponentState(state);
+
+	Session session(inst.component, processor, inst.controller, handler, opt);
+	if (!session.setup(block)) return 1;
+
+	struct Step { const char* name; Vst::ParamID id; Vst::ParamValue value; int restart; };  // restart: -1 either way
+	const Step steps[] = {
+		{ "restored x8", Vst::kNoParamId,   0.0, -1 },
+		{ "x1",          yg331::kParamOS,   x1,   1 },
+		{ "x8",          yg331::kParamOS,   x8,   1 },
+		{ "x1",          yg331::kParamOS,   x1,   1 },
+		{ "x1 again",    yg331::kParamOS,   x1,   0 },
+	};
+
+	// what the host knows, it asks getLatencySamples() after setup and on every restart
+	int32 known = (int32)processor->getLatencySamples();
+	int result = 0;
+	fprintf(file, "{\n  \"tool\": \"jsif_host\",\n  \"module\": \"%s\",\n  \"latency_check\": [", opt.module.c_str());
+	bool first = true;
+	for (const Step& s : steps)
+	{
+		bool restarted = session.step(block, s.id, s.value);
+		int32 latency  = (int32)processor->getLatencySamples();
+		if (restarted) known = latency;
+		int32 reported = (int32)std::lround(inst.controller->getParamNormalized(yg331::kParamLatency) * (double)yg331::JSIF_DSP::maxLatency);
+
+		bool ok = known == latency && reported == latency && (s.restart < 0 || (s.restart > 0) == restarted);
+		if (!ok) result = 1;
+		fprintf(file, "%s\n    {\"step\": \"%s\", \"latency\": %d, \"controller\": %d, \"host\": %d, \"restart\": %s, \"ok\": %s}",
+		        first ? "" : ",", s.name, latency, reported, known, restarted ? "true" : "false", ok ? "true" : "false");
+		first = false;
+	}
+	fprintf(file, "\n  ]\n}\n");
+
+	session.teardown();
+	inst.controller->setComponentHandler(nullptr);
+	if (result != 0)
+		fprintf(stderr, "jsif_host: a latency change did not reach the controller or the host\n");
+	return result;
+}
+
+//------------------------------------------------------------------------
+std::vector<int> intList(const char* arg)
+{
+	std::vector<int> values;
+	std::string s(arg);
+	size_t start = 0;
+	while (start <= s.size())
+	{
+		size_t comma = s.find(',', start);
+		if (comma == std::string::npos) comma = s.size();
+		if (comma > start) values.push_back(atoi(s.substr(start, comma - start).c_str()));
+		start = comma + 1;
+	}
+	return values;
+}
+
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_host MODULE.vst3 [options]\n"
+		"  --out FILE            write JSON to FILE instead of stdout\n"
+		"  --blocks LIST         block sizes, e.g. 32,512 (default 32,128,512,2048)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --seconds S           audio seconds per block size (default 5)\n"
+		"  --precision P         float or double (default float)\n"
+		"  --offline             processMode kOffline instead of kRealtime\n"
+		"  --switch-ms MS        step list parameters every MS milliseconds (default 250)\n"
+		"  --no-automation       no input parameter changes\n"
+		"  --lifecycle N         time creation of N instances instead of processing\n"
+		"  --rates LIST          sample rates for --lifecycle (default 44100,48000,96000,192000)\n"
+		"  --latency-check       check that every latency change reaches the host, exit 1 if not\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--offline")       opt.offline = true;
+		else if (a == "--no-automation") opt.automation = false;
+		else if (a == "--latency-check") opt.latencyCheck = true;
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if (a.compare(0, 2, "--") != 0 && opt.module.empty()) opt.module = a;
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")       opt.out = v;
+		else if (a == "--blocks")    opt.blocks = intList(v);
+		else if (a == "--rate")      opt.sampleRate = atof(v);
+		else if (a == "--seconds")   opt.seconds = atof(v);
+		else if (a == "--precision") opt.isDouble = (std::string(v) == "double");
+		else if (a == "--switch-ms") opt.switchMs = std::max(1.0, atof(v));
+		else if (a == "--lifecycle") opt.lifecycle = std::max(1, atoi(v));
+		else if (a == "--rates")     opt.rates = intList(v);
+		else { usage(); return false; }
+	}
+	if (opt.module.empty()) { usage(); return false; }
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	Vst::HostApplication hostApplication;
+	PluginContextFactory::instance().setPluginContext(&hostApplication);
+
+	std::string error;
+	VST3::Hosting::Module::Ptr module = VST3::Hosting::Module::create(opt.module, error);
+	if (!module)
+	{
+		fprintf(stderr, "jsif_host: cannot load %s: %s\n", opt.module.c_str(), error.c_str());
+		return 1;
+	}
+
+	VST3::Hosting::PluginFactory factory = module->getFactory();
+	const VST3::Hosting::ClassInfo* effectClass = nullptr;
+	auto classInfos = factory.classInfos();
+	for (auto& classInfo : classInfos)
+	{
+		if (classInfo.category() == kVstAudioEffectClass) { effectClass = &classInfo; break; }
+	}
+	if (!effectClass)
+	{
+		fprintf(stderr, "jsif_host: no audio effect class in %s\n", opt.module.c_str());
+		return 1;
+	}
+
+	if (opt.lifecycle > 0 || opt.latencyCheck)
+	{
+		FILE* file = stdout;
+		if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+		{
+			fprintf(stderr, "jsif_host: cannot open %s\n", opt.out.c_str());
+			return 1;
+		}
+		int result = opt.latencyCheck ? runLatencyCheck(factory, *effectClass, opt, file)
+		                              : runLifecycle(factory, *effectClass, &hostApplication, opt, file);
+		if (file != stdout) fclose(file);
+		return result;
+	}
+
+	IPtr<Vst::PlugProvider> provider = owned(new Vst::PlugProvider(factory, *effectClass, true));
+	if (!provider->initialize())
+	{
+		fprintf(stderr, "jsif_host: cannot create %s\n", effectClass->name().c_str());
+		return 1;
+	}
+
+	IPtr<Vst::IComponent> component = provider->getComponentPtr();
+	IPtr<Vst::IEditController> controller = provider->getControllerPtr();
+	FUnknownPtr<Vst::IAudioProcessor> processor(component);
+	if (!processor)
+	{
+		fprintf(stderr, "jsif_host: component has no IAudioProcessor\n");
+		return 1;
+	}
+
+	HostHandler handler;
+	if (controller)
+		controller->setComponentHandler(&handler);
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_host: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+
+	fprintf(file, "{\n  \"tool\": \"jsif_host\",\n  \"module\": \"%s\",\n  \"sample_rate\": %.1f,\n"
+	              "  \"precision\": \"%s\",\n  \"offline\": %s,\n  \"results\": [",
+	        opt.module.c_str(), opt.sampleRate, opt.isDouble ? "double" : "float", opt.offline ? "true" : "false");
+
+	Session session(component, processor, controller, handler, opt);
+	bool first = true;
+	int result = 0;
+	for (int block : opt.blocks)
+	{
+		if (block < 1) continue;
+		if (!session.setup(block)) { result = 1; break; }
+		Stats s = session.run(block);
+		session.teardown();
+
+		double deadline = 1e9 * (double)block / opt.sampleRate;
+		fprintf(file,
+			"%s\n    {\"block\": %d, \"calls\": %lld, \"deadline_ns\": %.1f, \"mean_ns\": %.1f, \"p50_ns\": %.1f, "
+			"\"p99_ns\": %.1f, \"p999_ns\": %.1f, \"max_ns\": %.1f, \"max_load\": %.4f, "
+			"\"input_points\": %lld, \"output_points\": %lld, \"latency_changes\": %lld, \"controller_ns_per_block\": %.1f}",
+			first ? "" : ",", block, s.calls, deadline, s.mean, s.p50, s.p99, s.p999, s.max, s.max / deadline,
+			s.inputPoints, s.outputPoints, s.latencyChanges, s.calls ? s.controllerNs / (double)s.calls : 0.0);
+		fflush(file);
+		first = false;
+	}
+	fprintf(file, "\n  ]\n}\n");
+	if (file != stdout) fclose(file);
+
+	if (controller)
+		controller->setComponentHandler(nullptr);
+	return result;
+}
@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_instances - cost of creating and preparing JSIF_DSP instances.
+//
+// Plug-in scans and template loads create hundreds of instances, each one
+// runs setupProcessing() which is JSIF_DSP::prepare(). For every sample
+// rate this creates --instances instances side by side and times each
+// phase per instance: construction, prepare(), a second prepare() (the
+// host changing the setup), reset() and destruction. Resident memory and
+// heap in use are read before and after all instances are prepared and
+// have processed one block, the difference per instance is reported.
+//
+// Each rate also gets the breakdown of JSIF_DSP::getMemoryReport() for one
+// instance. r8brain's internal allocations are not visible to the report,
+// the heap measured beyond the report is given as resampler_internal.
+// --low-footprint creates the instances with setLowFootprint(), --os and
+// --phase pick the mode of the one processed block.
+//
+// With --budget-ms and/or --budget-kb the run fails (exit code 1) when the
+// median construction + prepare time or the resident memory per instance
+// is over budget at any rate. ctest always runs the memory budget, which
+// does not depend on the machine's speed; the wall-clock budget is only
+// added with -DJSIF_TEST_BUDGETS=ON.
+//
+//   jsif_instances [--out file.json] [--instances N] [--rates 44100,48000,96000,192000]
+//                  [--channels N] [--block N] [--os N] [--phase fir|r8b] [--low-footprint]
+//                  [--budget-ms MS] [--budget-kb KB]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_memory.h"
+#include "jsif_tool_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+struct Options
+{
+	int              instances = 64;
+	std::vector<int> rates     = { 44100, 48000, 96000, 192000 };
+	int              channels  = 2;
+	int              block     = 1024;
+	int              os        = 1;
+	bool             linear    = false;
+	bool             lowFootprint = false;
+	double           budgetMs  = 0.0;  // 0 = no budget
+	double           budgetKb  = 0.0;
+	std::string      out;
+};
+
+enum Phase { kConstruct = 0, kPrepare, kReprepare, kReset, kDestruct, kNumPhases };
+
+const char* phaseName(int p)
+{
+	static const char* names[kNumPhases] = { "construct", "prepare", "reprepare", "reset", "destruct" };
+	return names[p];
+}
+
+struct RateResult
+{
+	int rate = 0;
+	double median[kNumPhases] = { 0.0, };  // ms per instance
+	double max   [kNumPhases] = { 0.0, };
+	double createMedian = 0.0;             // construct + prepare, ms
+	double residentKb   = 0.0;             // per instance
+	double heapKb       = 0.0;             // per instance
+	JSIF_DSP::MemoryReport memory;         // first instance
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> v)
+{
+	if (v.empty()) return 0.0;
+	std::sort(v.begin(), v.end());
+	return v[v.size() / 2];
+}
+
+//------------------------------------------------------------------------
+RateResult run(const Options& opt, int rate)
+{
+	using clock = std::chrono::steady_clock;
+
+	RateResult r;
+	r.rate = rate;
+	std::vector<double> times[kNumPhases];
+	std::vector<double> create;
+
+#if defined(__GLIBC__)
+	// hand freed pages of the previous rate back, or they would hide this rate's memory
+	malloc_trim(0);
+#endif
+	uint64_t residentBefore = residentBytes();
+	uint64_t heapBefore     = heapBytes();
+
+	std::vector<std::unique_ptr<JSIF_DSP>> instances(opt.instances);
+	for (auto& dsp : instances)
+	{
+		auto start = clock::now();
+		dsp.reset(new JSIF_DSP());
+		double construct = elapsedMs(start);
+
+		dsp->setLowFootprint(opt.lowFootprint);
+		dsp->setOverSample(toOverSample(opt.os));
+		dsp->setLinearPhase(opt.linear);
+
+		start = clock::now();
+		dsp->prepare((double)rate, opt.channels, opt.block);
+		double prepare = elapsedMs(start);
+
+		times[kConstruct].push_back(construct);
+		times[kPrepare].push_back(prepare);
+		create.push_back(construct + prepare);
+	}
+
+	// one block each, r8brain allocates part of its buffers on first use
+	std::vector<std::vector<float>> silence(opt.channels, std::vector<float>(opt.block, 0.0f));
+	std::vector<float*> ptr(opt.channels);
+	for (int ch = 0; ch < opt.channels; ch++) ptr[ch] = silence[ch].data();
+	for (auto& dsp : instances)
+		dsp->process(ptr.data(), ptr.data(), opt.channels, opt.block);
+
+	uint64_t residentAfter = residentBytes();
+	uint64_t heapAfter     = heapBytes();
+	if (residentAfter > residentBefore)
+		r.residentKb = (double)(residentAfter - residentBefore) / 1024.0 / (double)opt.instances;
+	if (heapAfter > heapBefore)
+		r.heapKb = (double)(heapAfter - heapBefore) / 1024.0 / (double)opt.instances;
+	r.memory = instances.front()->getMemoryReport();
+
+	for (auto& dsp : instances)
+	{
+		auto start = clock::now();
+		dsp->prepare((double)rate, opt.channels, opt.block);
+		times[kReprepare].push_back(elapsedMs(start));
+
+		start = clock::now();
+		dsp->reset();
+		times[kReset].push_back(elapsedMs(start));
+	}
+
+	for (auto& dsp : instances)
+	{
+		auto start = clock::now();
+		dsp.reset();
+		times[kDestruct].push_back(elapsedMs(start));
+	}
+
+	for (int p = 0; p < kNumPhases; p++)
+	{
+		r.median[p] = median(times[p]);
+		r.max[p]    = times[p].empty() ? 0.0 : *std::max_element(times[p].begin(), times[p].end());
+	}
+	r.createMedian = median(create);
+	return r;
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_instances [options]\n"
+		"  --out FILE            write JSON to FILE instead of stdout\n"
+		"  --instances N         instances alive at the same time (default 64)\n"
+		"  --rates LIST          sample rates (default 44100,48000,96000,192000)\n"
+		"  --channels N          channels per instance (default 2)\n"
+		"  --block N             max samples per block (default 1024)\n"
+		"  --os N                oversampling of the processed block, 1, 2, 4 or 8 (default 1)\n"
+		"  --phase fir|r8b       phase of the processed block (default fir)\n"
+		"  --low-footprint       create resamplers and latency rings only when needed\n"
+		"  --budget-ms MS        fail when median construct + prepare exceeds MS\n"
+		"  --budget-kb KB        fail when resident memory per instance exceeds KB\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if (a == "--low-footprint") opt.lowFootprint = true;
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")       opt.out = v;
+		else if (a == "--instances") opt.instances = std::max(1, atoi(v));
+		else if (a == "--rates")     opt.rates = intList(v);
+		else if (a == "--channels")  opt.channels = std::max(1, atoi(v));
+		else if (a == "--block")     opt.block = std::max(1, atoi(v));
+		else if (a == "--os")        opt.os = atoi(v);
+		else if (a == "--phase")     opt.linear = (std::string(v) == "r8b");
+		else if (a == "--budget-ms") opt.budgetMs = atof(v);
+		else if (a == "--budget-kb") opt.budgetKb = atof(v);
+		else { usage(); return false; }
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_instances: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+
+	fprintf(file, "{\n  \"tool\": \"jsif_instances\",\n  \"instances\": %d,\n  \"channels\": %d,\n  \"block\": %d,\n"
+	              "  \"os\": %d,\n  \"phase\": \"%s\",\n  \"low_footprint\": %s,\n"
+	              "  \"budget_ms\": %.3f,\n  \"budget_kb\": %.1f,\n  \"results\": [",
+	        opt.instances, opt.channels, opt.block, opt.os, opt.linear ? "r8b" : "fir",
+	        opt.lowFootprint ? "true" : "false", opt.budgetMs, opt.budgetKb);
+
+	bool overBudget = false;
+	bool first = true;
+	for (int rate : opt.rates)
+	{
+		if (rate <= 0) continue;
+		RateResult r = run(opt, rate);
+
+		fprintf(file, "%s\n    {\"rate\": %d, \"create_median_ms\": %.4f, \"resident_kb\": %.1f, \"heap_kb\": %.1f",
+		        first ? "" : ",", r.rate, r.createMedian, r.residentKb, r.heapKb);
+		first = false;
+		for (int p = 0; p < kNumPhases; p++)
+			fprintf(file, ", \"%s_median_ms\": %.4f, \"%s_max_ms\": %.4f", phaseName(p), r.median[p], phaseName(p), r.max[p]);
+
+		const JSIF_DSP::MemoryReport& m = r.memory;
+		double internalKb = std::max(0.0, r.heapKb - (double)m.total() / 1024.0);
+		fprintf(file, ",\n     \"memory_kb\": {\"total\": %.1f, \"object\": %.1f, \"filters\": %.1f, \"resamplers\": %.1f, "
+		              "\"resampler_count\": %d, \"resampler_internal\": %.1f, \"latency\": %.1f, \"buffers\": %.1f, "
+		              "\"meters\": %.1f, \"other\": %.1f, \"shared\": %.1f}}",
+		        m.total() / 1024.0, m.object / 1024.0, m.filters / 1024.0, m.resamplers / 1024.0,
+		        m.resamplerCount, internalKb, m.latency / 1024.0, m.buffers / 1024.0,
+		        m.meters / 1024.0, m.other / 1024.0, m.shared / 1024.0);
+
+		if (opt.budgetMs > 0.0 && r.createMedian > opt.budgetMs)
+		{
+			fprintf(stderr, "jsif_instances: %d Hz: construct + prepare takes %.3f ms, budget %.3f ms\n",
+			        r.rate, r.createMedian, opt.budgetMs);
+			overBudget = true;
+		}
+		if (opt.budgetKb > 0.0 && r.residentKb > opt.budgetKb)
+		{
+			fprintf(stderr, "jsif_instances: %d Hz: %.1f KB resident per instance, budget %.1f KB\n",
+			        r.rate, r.residentKb, opt.budgetKb);
+			overBudget = true;
+		}
+	}
+	fprintf(file, "\n  ]\n}\n");
+	if (file != stdout) fclose(file);
+
+	return overBudget ? 1 : 0;
+}
@@ -0,0 +1,301 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_latency - worst case timing of JSIF_DSP::process().
+//
+// Times every single process() call and reports p50, p99, p99.9 and max
+// per block size, next to the block deadline (frames / sample rate).
+// Averages hide the spikes realtime buffers have to be sized for, so
+// every call is kept. Scenarios:
+//
+//   steady      fixed parameters, continuous signal
+//   automation  input, curve, effect and output move every block, clip
+//               and split toggle every 50 ms
+//   switch      OS and Phase step through every combination every
+//               100 ms, latency and resamplers change on those blocks
+//   silence     500 ms of digital silence and 500 ms of signal in turn
+//
+// Results are JSON, one row per scenario, mode and block size. The switch
+// rows also give the max of the switching blocks alone.
+//
+//   jsif_latency [--quick] [--out file.json] [--seconds S] [--min-calls N]
+//                [--os 1,2,4,8] [--phase fir,r8b] [--blocks 1,2,...,4096]
+//                [--channels N] [--rate HZ]
+//                [--scenarios steady,automation,switch,silence]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_tool_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+enum Scenario { kSteady = 0, kAutomation, kSwitch, kSilence, kNumScenarios };
+
+const char* scenarioName(int s)
+{
+	static const char* names[kNumScenarios] = { "steady", "automation", "switch", "silence" };
+	return names[s];
+}
+
+struct Options
+{
+	std::vector<int>  os         = { 1, 2, 4, 8 };
+	std::vector<bool> linear     = { false, true };
+	std::vector<int>  blocks     = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+	std::vector<int>  scenarios  = { kSteady, kAutomation, kSwitch, kSilence };
+	int               channels   = 2;
+	double            sampleRate = 48000.0;
+	double            seconds    = 2.0;   // audio per run
+	int               minCalls   = 2000;  // enough calls for a p99.9
+	std::string       out;
+};
+
+struct Stats
+{
+	long long calls = 0;
+	double p50 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0, mean = 0.0;  // ns
+	double switchMax = -1.0;  // ns, switch scenario only
+};
+
+// nearest rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty()) return 0.0;
+	size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+	return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+Stats summarize(std::vector<double>& times, const std::vector<double>& switchTimes)
+{
+	Stats s;
+	s.calls = (long long)times.size();
+	if (times.empty()) return s;
+
+	double sum = 0.0;
+	for (double t : times) sum += t;
+	s.mean = sum / (double)times.size();
+
+	std::sort(times.begin(), times.end());
+	s.p50  = percentile(times, 0.50);
+	s.p99  = percentile(times, 0.99);
+	s.p999 = percentile(times, 0.999);
+	s.max  = times.back();
+
+	if (!switchTimes.empty())
+		s.switchMax = *std::max_element(switchTimes.begin(), switchTimes.end());
+	return s;
+}
+
+//------------------------------------------------------------------------
+// Runs one scenario at one block size, timing each process() call.
+Stats run(const Options& opt, Scenario scenario, int os, bool linear, int block)
+{
+	using clock = std::chrono::steady_clock;
+
+	const int32_t channels = opt.channels;
+	const double  rate     = opt.sampleRate;
+	const long long calls  = std::max<long long>(opt.minCalls, (long long)(opt.seconds * rate / block));
+
+	JSIF_DSP dsp;
+	dsp.prepare(rate, channels, block);
+	dsp.setInput(0.5);
+	dsp.setEffect(1.0);
+	dsp.setCurve(0.5);
+	dsp.setOutput(1.0);
+	dsp.setOverSample(toOverSample(os));
+	dsp.setLinearPhase(linear);
+	dsp.setIn(true);
+
+	// one second of material, played in a loop
+	const size_t loop = (size_t)rate;
+	std::vector<std::vector<float>> source(channels, std::vector<float>(loop));
+	fillSignal(source, rate);
+	std::vector<std::vector<float>> buffer(channels, std::vector<float>(block));
+	std::vector<float*> ptr(channels);
+	for (int32_t ch = 0; ch < channels; ch++) ptr[ch] = buffer[ch].data();
+
+	// OS/Phase combinations visited by the switch scenario
+	struct Mode { int os; bool linear; };
+	static const Mode modes[] = { { 1, false }, { 2, false }, { 4, false }, { 8, false },
+	                              { 2, true  }, { 4, true  }, { 8, true  } };
+	const int numModes = (int)(sizeof(modes) / sizeof(modes[0]));
+
+	const long long switchEvery = std::max<long long>(1, (long long)(0.1 * rate / block));
+	const long long toggleEvery = std::max<long long>(1, (long long)(0.05 * rate / block));
+	const long long silenceLen  = std::max<long long>(1, (long long)(0.5 * rate / block));
+
+	std::vector<double> times, switchTimes;
+	times.reserve((size_t)calls);
+
+	size_t position = 0;
+	int modeIndex = 0;
+
+	// warm up, r8brain allocates its buffers lazily on the first calls
+	for (int i = 0; i < 4; i++)
+		dsp.process(ptr.data(), ptr.data(), channels, block);
+	dsp.reset();
+
+	for (long long call = 0; call < calls; call++)
+	{
+		// input for this block, copied before timing starts
+		bool silent = (scenario == kSilence) && ((call / silenceLen) % 2 == 0);
+		for (int32_t ch = 0; ch < channels; ch++)
+		{
+			if (silent)
+				std::fill(buffer[ch].begin(), buffer[ch].end(), 0.0f);
+			else
+				for (int i = 0; i < block; i++)
+					buffer[ch][i] = source[ch][(position + i) % loop];
+		}
+		position = (position + block) % loop;
+
+		bool switching = false;
+		auto start = clock::now();
+
+		// parameter changes land between blocks, as with the plug-in's queue handling
+		if (scenario == kAutomation)
+		{
+			double phase = (double)call * block / rate;
+			dsp.setParam(JSIF_DSP::kInput,  0.5 + 0.25 * std::sin(2.0 * M_PI * 0.5 * phase));
+			dsp.setParam(JSIF_DSP::kCurve,  0.5 + 0.5  * std::sin(2.0 * M_PI * 0.3 * phase));
+			dsp.setParam(JSIF_DSP::kEffect, 0.5 + 0.5  * std::sin(2.0 * M_PI * 0.7 * phase));
+			dsp.setParam(JSIF_DSP::kOutput, 0.8 + 0.2  * std::sin(2.0 * M_PI * 0.2 * phase));
+			if (call % toggleEvery == 0)
+			{
+				dsp.setClip ((call / toggleEvery) % 2 == 1);
+				dsp.setSplit((call / toggleEvery) % 3 == 1);
+			}
+		}
+		else if (scenario == kSwitch && call > 0 && call % switchEvery == 0)
+		{
+			modeIndex = (modeIndex + 1) % numModes;
+			dsp.setParam(JSIF_DSP::kOS, JSIF_DSP::overSampleToNormalized(toOverSample(modes[modeIndex].os)));
+			dsp.setParam(JSIF_DSP::kPhase, modes[modeIndex].linear ? 1.0 : 0.0);
+			switching = true;
+		}
+
+		dsp.process(ptr.data(), ptr.data(), channels, block);
+
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+		times.push_back(ns);
+		if (switching) switchTimes.push_back(ns);
+	}
+
+	return summarize(times, switchTimes);
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_latency [options]\n"
+		"  --out FILE            write JSON to FILE instead of stdout\n"
+		"  --quick               fewer modes and block sizes for a fast sanity run\n"
+		"  --seconds S           audio seconds per run (default 2)\n"
+		"  --min-calls N         minimum process() calls per run (default 2000)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --channels N          channel count (default 2)\n"
+		"  --os LIST             oversampling factors, e.g. 1,2,4,8\n"
+		"  --phase LIST          fir,r8b\n"
+		"  --blocks LIST         e.g. 1,64,4096\n"
+		"  --scenarios LIST      steady,automation,switch,silence\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--quick") {
+			opt.os = { 1, 8 }; opt.blocks = { 1, 32, 512, 4096 };
+			opt.seconds = 0.5; opt.minCalls = 1000;
+		}
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")       opt.out = v;
+		else if (a == "--seconds")   opt.seconds = atof(v);
+		else if (a == "--min-calls") opt.minCalls = std::max(1, atoi(v));
+		else if (a == "--rate")      opt.sampleRate = atof(v);
+		else if (a == "--channels")  opt.channels = std::max(1, atoi(v));
+		else if (a == "--os")        opt.os = intList(v);
+		else if (a == "--phase")     opt.linear = boolList(v, "r8b");
+		else if (a == "--blocks")    opt.blocks = intList(v);
+		else if (a == "--scenarios")
+		{
+			opt.scenarios.clear();
+			for (auto& name : splitList(v))
+				for (int s = 0; s < kNumScenarios; s++)
+					if (name == scenarioName(s)) opt.scenarios.push_back(s);
+		}
+		else { usage(); return false; }
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_latency: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+
+	fprintf(file, "{\n  \"tool\": \"jsif_latency\",\n  \"sample_rate\": %.1f,\n  \"channels\": %d,\n  \"results\": [",
+	        opt.sampleRate, opt.channels);
+
+	bool first = true;
+	for (int scenario : opt.scenarios)
+	for (int os : opt.os)
+	for (bool linear : opt.linear)
+	{
+		// 1x has no oversampler, phase makes no difference
+		if (os == 1 && linear && opt.linear.size() > 1) continue;
+		// switch cycles through every mode by itself, os/phase are where it starts
+		if (scenario == kSwitch && (os != opt.os.front() || linear != opt.linear.front())) continue;
+
+		for (int block : opt.blocks)
+		{
+			if (block < 1) continue;
+			Stats s = run(opt, (Scenario)scenario, os, linear, block);
+			double deadline = 1e9 * (double)block / opt.sampleRate;
+
+			fprintf(file,
+				"%s\n    {\"scenario\": \"%s\", \"os\": %d, \"phase\": \"%s\", \"block\": %d, \"calls\": %lld, "
+				"\"deadline_ns\": %.1f, \"mean_ns\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f, "
+				"\"max_ns\": %.1f, \"max_load\": %.4f",
+				first ? "" : ",", scenarioName(scenario), os, linear ? "r8b" : "fir", block, s.calls,
+				deadline, s.mean, s.p50, s.p99, s.p999, s.max, s.max / deadline);
+			if (s.switchMax >= 0.0)
+				fprintf(file, ", \"switch_max_ns\": %.1f", s.switchMax);
+			fprintf(file, "}");
+			fflush(file);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	if (file != stdout) fclose(file);
+	return 0;
+}
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// Resident memory of the running process for the tools. Linux reads
+// /proc/self/statm, macOS asks the task, elsewhere 0 is returned.
+// Heap bytes in use come from glibc's mallinfo, elsewhere 0. The last
+// level cache size comes from sysfs on Linux and sysctl on macOS.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace yg331 {
+
+/** Resident set size in bytes, 0 when unknown. */
+inline uint64_t residentBytes()
+{
+#if defined(__linux__)
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (!file) return 0;
+	unsigned long long size = 0, resident = 0;
+	int fields = fscanf(file, "%llu %llu", &size, &resident);
+	fclose(file);
+	return (fields == 2) ? (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+	return (uint64_t)info.resident_size;
+#else
+	return 0;
+#endif
+}
+
+/** Heap bytes handed out by malloc and not yet freed, 0 when unknown. */
+inline uint64_t heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	return (uint64_t)mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+	return (uint64_t)(unsigned int)mallinfo().uordblks;
+#else
+	return 0;
+#endif
+}
+
+/** Size of the largest cache the first CPU sees, 0 when unknown. */
+inline uint64_t lastLevelCacheBytes()
+{
+#if defined(__linux__)
+	uint64_t largest = 0;
+	for (int index = 0; index < 8; index++)
+	{
+		char path[96];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+		FILE* file = fopen(path, "r");
+		if (!file) break;
+		unsigned long long size = 0;
+		char unit = 0;
+		int fields = fscanf(file, "%llu%c", &size, &unit);
+		fclose(file);
+		if (fields < 1) continue;
+		if (fields == 2 && (unit == 'K' || unit == 'k')) size *= 1024ull;
+		else if (fields == 2 && (unit == 'M' || unit == 'm')) size *= 1024ull * 1024ull;
+		largest = (size > largest) ? size : largest;
+	}
+	return largest;
+#elif defined(__APPLE__)
+	uint64_t size = 0;
+	size_t length = sizeof(size);
+	if (sysctlbyname("hw.l3cachesize", &size, &length, nullptr, 0) == 0 && size > 0)
+		return size;
+	length = sizeof(size);
+	if (sysctlbyname("hw.l2cachesize", &size, &length, nullptr, 0) == 0)
+		return size;
+	return 0;
+#else
+	return 0;
+#endif
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
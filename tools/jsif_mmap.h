@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// Memory mapped files for the command line tools, POSIX only. Elsewhere
+// MappedFile::supported() is false and the tools use stream I/O.
+//
+// The whole file is mapped at once, address space is not the limit on 64
+// bit hosts. What is resident is: release() drops a processed range from
+// the process and, for clean pages, from the page cache, writeBack()
+// starts writing a finished output range so dirty pages do not pile up
+// until the end.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSIF_HAVE_MMAP 1
+#endif
+
+namespace yg331 {
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	static bool supported()
+	{
+#ifdef JSIF_HAVE_MMAP
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/** Maps an existing file read only. */
+	bool openRead(const std::string& path, std::string& error)
+	{
+		close();
+#ifdef JSIF_HAVE_MMAP
+		fd = ::open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) != 0) { error = "cannot open " + path; close(); return false; }
+		length = (uint64_t)info.st_size;
+		if (length == 0) { error = "empty file " + path; close(); return false; }
+		void* p = mmap(nullptr, (size_t)length, PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) { error = "cannot map " + path; close(); return false; }
+		base = (uint8_t*)p;
+		madvise(base, (size_t)length, MADV_SEQUENTIAL);
+		return true;
+#else
+		error = "memory mapping not supported";
+		return false;
+#endif
+	}
+
+	/** Creates (or truncates) a file of `size` bytes and maps it for writing. */
+	bool create(const std::string& path, uint64_t size, std::string& error)
+	{
+		close();
+#ifdef JSIF_HAVE_MMAP
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) { error = "cannot create " + path; return false; }
+		if (ftruncate(fd, (off_t)size) != 0) { error = "cannot allocate " + path; close(); return false; }
+		length = size;
+		void* p = mmap(nullptr, (size_t)length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) { error = "cannot map " + path; close(); return false; }
+		base = (uint8_t*)p;
+		writable = true;
+		madvise(base, (size_t)length, MADV_SEQUENTIAL);
+		return true;
+#else
+		error = "memory mapping not supported";
+		return false;
+#endif
+	}
+
+	uint8_t* data() const { return base; }
+	uint64_t size() const { return length; }
+
+	/** Done with [offset, offset + bytes): unmaps the pages from the process, output pages stay in the page cache until written. */
+	void release(uint64_t offset, uint64_t bytes)
+	{
+#ifdef JSIF_HAVE_MMAP
+		if (!alignRange(offset, bytes)) return;
+		madvise(base + offset, (size_t)bytes, MADV_DONTNEED);
+#if defined(POSIX_FADV_DONTNEED)
+		if (!writable) posix_fadvise(fd, (off_t)offset, (off_t)bytes, POSIX_FADV_DONTNEED);
+#endif
+#endif
+	}
+
+	/** Starts writing back [offset, offset + bytes) without waiting. */
+	void writeBack(uint64_t offset, uint64_t bytes)
+	{
+#ifdef JSIF_HAVE_MMAP
+		if (!writable || !alignRange(offset, bytes)) return;
+		msync(base + offset, (size_t)bytes, MS_ASYNC);
+#endif
+	}
+
+	/** Unmaps, a written file is cut to `truncateTo` bytes when given. */
+	bool close(uint64_t truncateTo = UINT64_MAX)
+	{
+		bool ok = true;
+#ifdef JSIF_HAVE_MMAP
+		if (base) ok &= (munmap(base, (size_t)length) == 0);
+		if (fd >= 0)
+		{
+			if (writable && truncateTo < length) ok &= (ftruncate(fd, (off_t)truncateTo) == 0);
+			ok &= (::close(fd) == 0);
+		}
+#endif
+		base = nullptr;
+		fd = -1;
+		length = 0;
+		writable = false;
+		return ok;
+	}
+
+private:
+	// page aligned start, ranges beyond the file are cut
+	bool alignRange(uint64_t& offset, uint64_t& bytes) const
+	{
+#ifdef JSIF_HAVE_MMAP
+		if (!base || offset >= length) return false;
+		uint64_t page  = (uint64_t)sysconf(_SC_PAGESIZE);
+		uint64_t start = offset - offset % page;
+		uint64_t end   = std::min<uint64_t>(offset + bytes, length);
+		if (end < length) end -= end % page;  // the partial page is still in use
+		if (end <= start) return false;
+		offset = start;
+		bytes  = end - start;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	uint8_t* base = nullptr;
+	uint64_t length = 0;
+	int      fd = -1;
+	bool     writable = false;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// Hardware performance counters for the tools, read via Linux
+// perf_event_open. Every counter is opened on its own so a missing one
+// (common in VMs and containers, or with perf_event_paranoid > 2) only
+// drops that value. On other platforms nothing is available.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace yg331 {
+
+class PerfCounters
+{
+public:
+	enum Counter {
+		kCycles = 0,
+		kInstructions,
+		kL1DMisses,
+		kLLCMisses,
+		kBranchMisses,
+		kNumCounters
+	};
+
+	static const char* name(int counter)
+	{
+		static const char* names[kNumCounters] = {
+			"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+		};
+		return names[counter];
+	}
+
+	struct Values
+	{
+		bool     valid[kNumCounters] = { false, };
+		double   count[kNumCounters] = { 0.0, };
+
+		bool any() const
+		{
+			for (bool v : valid) if (v) return true;
+			return false;
+		}
+		/** Instructions per cycle, negative when either counter is missing. */
+		double ipc() const
+		{
+			if (!valid[kCycles] || !valid[kInstructions] || count[kCycles] <= 0.0) return -1.0;
+			return count[kInstructions] / count[kCycles];
+		}
+	};
+
+	PerfCounters()
+	{
+#if defined(__linux__)
+		const uint64_t cacheRead = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+		fd[kCycles]       = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		fd[kInstructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		fd[kL1DMisses]    = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cacheRead);
+		fd[kLLCMisses]    = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL  | cacheRead);
+		fd[kBranchMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+	}
+
+	~PerfCounters()
+	{
+#if defined(__linux__)
+		for (int f : fd) if (f >= 0) close(f);
+#endif
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool available() const
+	{
+		for (int f : fd) if (f >= 0) return true;
+		return false;
+	}
+
+	void start()
+	{
+#if defined(__linux__)
+		for (int f : fd)
+		{
+			if (f < 0) continue;
+			ioctl(f, PERF_EVENT_IOC_RESET, 0);
+			ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	/** Stops counting and returns the counts since start(), scaled for multiplexing. */
+	Values stop()
+	{
+		Values values;
+#if defined(__linux__)
+		for (int i = 0; i < kNumCounters; i++)
+		{
+			if (fd[i] < 0) continue;
+			ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+
+			uint64_t data[3] = { 0, }; // value, time enabled, time running
+			if (read(fd[i], data, sizeof(data)) != (ssize_t)sizeof(data) || data[2] == 0)
+				continue;
+			values.valid[i] = true;
+			values.count[i] = (double)data[0] * ((double)data[1] / (double)data[2]);
+		}
+#endif
+		return values;
+	}
+
+private:
+#if defined(__linux__)
+	static int open(uint32_t type, uint64_t config)
+	{
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = type;
+		attr.config         = config;
+		attr.disabled       = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.inherit        = 1; // include the channel worker threads
+		attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+	}
+#endif
+
+	int fd[kNumCounters] = { -1, -1, -1, -1, -1 };
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331
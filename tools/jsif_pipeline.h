@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// Building blocks for the threaded tool pipelines: a bounded lock-free
+// single producer / single consumer queue, and waiting helpers that back
+// off from spinning to yielding to short sleeps, so a stage that waits on
+// the disk does not burn a core. Every wait gives up when the shared abort
+// flag is raised, which is how a failing stage stops the others.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace yg331 {
+
+//------------------------------------------------------------------------
+template <typename T>
+class SpscQueue
+{
+public:
+	explicit SpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/** Producer side, false when full. */
+	bool push(const T& value)
+	{
+		size_t w    = writeIndex.load(std::memory_order_relaxed);
+		size_t next = (w + 1 == slots.size()) ? 0 : w + 1;
+		if (next == readIndex.load(std::memory_order_acquire))
+			return false;
+		slots[w] = value;
+		writeIndex.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/** Consumer side, false when empty. */
+	bool pop(T& value)
+	{
+		size_t r = readIndex.load(std::memory_order_relaxed);
+		if (r == writeIndex.load(std::memory_order_acquire))
+			return false;
+		value = slots[r];
+		readIndex.store((r + 1 == slots.size()) ? 0 : r + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::vector<T> slots;
+	alignas(64) std::atomic<size_t> writeIndex { 0 };
+	alignas(64) std::atomic<size_t> readIndex  { 0 };
+};
+
+//------------------------------------------------------------------------
+class Backoff
+{
+public:
+	void pause()
+	{
+		if (++rounds < 64) return;
+		if (rounds < 256) { std::this_thread::yield(); return; }
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+private:
+	int rounds = 0;
+};
+
+/** Pushes, waiting while the queue is full. False when aborted. */
+template <typename T>
+bool pushWait(SpscQueue<T>& queue, const T& value, const std::atomic<bool>& abort)
+{
+	Backoff backoff;
+	while (!queue.push(value))
+	{
+		if (abort.load(std::memory_order_relaxed)) return false;
+		backoff.pause();
+	}
+	return true;
+}
+
+/** Pops, waiting while the queue is empty. False when aborted. */
+template <typename T>
+bool popWait(SpscQueue<T>& queue, T& value, const std::atomic<bool>& abort)
+{
+	Backoff backoff;
+	while (!queue.pop(value))
+	{
+		if (abort.load(std::memory_order_relaxed)) return false;
+		backoff.pause();
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,344 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_quality - aliasing and THD+N against CPU cost per oversampling mode.
+//
+// Every mode renders sines stepped across the band at several drive and
+// curve settings. Frequencies are snapped to an odd FFT bin, so the output
+// is periodic in the FFT length and needs no window: the fundamental, its
+// in-band harmonics and every other bin are exact.
+//
+//   THD+N     everything but DC and the fundamental, relative to the fundamental
+//   aliasing  everything but DC, the fundamental and its in-band harmonics,
+//             i.e. harmonics folded back from above Nyquist (plus noise)
+//
+// CPU cost is the chain's ns per sample for the same mode, best of a few
+// passes over one second of audio. The summary per mode gives the worst
+// and mean figures, as JSON or as a CSV table (--csv).
+//
+//   jsif_quality [--out file] [--csv] [--os 1,2,4,8] [--phase fir,r8b]
+//                [--freqs 100,1000,...] [--drives 0,6,12] [--curves -50,0,50]
+//                [--rate HZ] [--fft N] [--split 0,1]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_tool_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+struct Options
+{
+	std::vector<int>  os         = { 1, 2, 4, 8 };
+	std::vector<bool> linear     = { false, true };
+	std::vector<bool> split      = { false };
+	std::vector<int>  freqs      = { 100, 1000, 3000, 6000, 10000, 15000, 20000 };
+	std::vector<int>  drives     = { 0, 6, 12 };     // dB of input gain
+	std::vector<int>  curves     = { -50, 0, 50 };   // %
+	double            sampleRate = 48000.0;
+	int               fftSize    = 32768;
+	bool              csv        = false;
+	std::string       out;
+};
+
+struct Point
+{
+	double freq, driveDb, curve;
+	double thdn, aliasing;  // dB relative to the fundamental
+};
+
+struct ModeResult
+{
+	int os; bool linear; bool split;
+	double nsPerSample = 0.0;
+	std::vector<Point> points;
+};
+
+//------------------------------------------------------------------------
+// in place radix 2 FFT, size must be a power of two
+void fft(std::vector<std::complex<double>>& x)
+{
+	const size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; i++)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) std::swap(x[i], x[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1)
+	{
+		double angle = -2.0 * M_PI / (double)len;
+		std::complex<double> step(std::cos(angle), std::sin(angle));
+		for (size_t i = 0; i < n; i += len)
+		{
+			std::complex<double> w(1.0, 0.0);
+			for (size_t k = 0; k < len / 2; k++)
+			{
+				std::complex<double> u = x[i + k];
+				std::complex<double> v = x[i + k + len / 2] * w;
+				x[i + k]           = u + v;
+				x[i + k + len / 2] = u - v;
+				w *= step;
+			}
+		}
+	}
+}
+
+void configure(JSIF_DSP& dsp, const Options& opt, int os, bool linear, bool split, int block)
+{
+	dsp.prepare(opt.sampleRate, 1, block);
+	dsp.setEffect(1.0);
+	dsp.setOutput(1.0);
+	dsp.setOverSample(toOverSample(os));
+	dsp.setLinearPhase(linear);
+	dsp.setSplit(split);
+	dsp.setClip(false);
+	dsp.setIn(true);
+	dsp.setBypass(false);
+	dsp.setMetering(false);
+}
+
+// Renders a bin centered sine and measures THD+N and aliasing of one period
+Point measure(const Options& opt, int os, bool linear, bool split, double freq, double driveDb, double curve)
+{
+	const int n     = opt.fftSize;
+	const int block = 512;
+
+	int bin = (int)std::lround(freq * n / opt.sampleRate) | 1;
+	bin = std::min(bin, n / 2 - 1);
+	const double f0 = bin * opt.sampleRate / n;
+
+	JSIF_DSP dsp;
+	configure(dsp, opt, os, linear, split, block);
+	dsp.setInput((driveDb + 12.0) / 24.0);
+	dsp.setCurve(curve / 100.0 + 0.5);
+
+	// settle past the latency and filter tails, then capture one FFT frame
+	const int settle = (JSIF_DSP::maxLatency / block + 8) * block;
+	const int total  = settle + n;
+	std::vector<double> signal(total);
+	for (int i = 0; i < total; i++)
+		signal[i] = 0.5 * std::sin(2.0 * M_PI * f0 * (double)i / opt.sampleRate);
+
+	for (int offset = 0; offset < total; offset += block)
+	{
+		double* ptr[1] = { signal.data() + offset };
+		dsp.process(ptr, ptr, 1, std::min(block, total - offset));
+	}
+
+	std::vector<std::complex<double>> spectrum(n);
+	for (int i = 0; i < n; i++) spectrum[i] = signal[settle + i];
+	fft(spectrum);
+
+	std::vector<double> power(n / 2 + 1);
+	for (int k = 0; k <= n / 2; k++) power[k] = std::norm(spectrum[k]);
+
+	double fundamental = power[bin];
+	double rest = 0.0, inharmonic = 0.0;
+	for (int k = 1; k <= n / 2; k++)
+	{
+		if (k == bin) continue;
+		rest += power[k];
+		if (k % bin != 0) inharmonic += power[k];
+	}
+
+	auto toDb = [&](double p) { return 10.0 * std::log10(std::max(p, 1e-30) / std::max(fundamental, 1e-30)); };
+	return { f0, driveDb, curve, toDb(rest), toDb(inharmonic) };
+}
+
+// best of three passes over one second, ns per sample
+double cost(const Options& opt, int os, bool linear, bool split)
+{
+	const int block = 512;
+	const int total = (int)opt.sampleRate;
+
+	std::vector<std::vector<double>> source(1, std::vector<double>(total));
+	fillSignal(source, opt.sampleRate);
+
+	JSIF_DSP dsp;
+	configure(dsp, opt, os, linear, split, block);
+	dsp.setInput(0.75);
+	dsp.setCurve(0.5);
+
+	double best = 1e30;
+	for (int pass = 0; pass < 3; pass++)
+	{
+		std::vector<double> buffer(source[0]);
+		auto start = std::chrono::steady_clock::now();
+		for (int offset = 0; offset < total; offset += block)
+		{
+			double* ptr[1] = { buffer.data() + offset };
+			dsp.process(ptr, ptr, 1, std::min(block, total - offset));
+		}
+		best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best / (double)total;
+}
+
+//------------------------------------------------------------------------
+void summarize(const ModeResult& m, double& worstAlias, double& meanAlias, double& worstThdn, double& meanThdn)
+{
+	worstAlias = worstThdn = -1e30;
+	meanAlias = meanThdn = 0.0;
+	for (auto& p : m.points)
+	{
+		worstAlias = std::max(worstAlias, p.aliasing);
+		worstThdn  = std::max(worstThdn,  p.thdn);
+		meanAlias += p.aliasing;
+		meanThdn  += p.thdn;
+	}
+	if (!m.points.empty())
+	{
+		meanAlias /= (double)m.points.size();
+		meanThdn  /= (double)m.points.size();
+	}
+}
+
+std::string modeName(const ModeResult& m)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "x%d %s%s", m.os, m.linear ? "r8b" : "fir", m.split ? " split" : "");
+	return name;
+}
+
+void writeJson(FILE* file, const Options& opt, const std::vector<ModeResult>& results)
+{
+	fprintf(file, "{\n  \"tool\": \"jsif_quality\",\n  \"sample_rate\": %.1f,\n  \"fft_size\": %d,\n  \"modes\": [",
+	        opt.sampleRate, opt.fftSize);
+	for (size_t r = 0; r < results.size(); r++)
+	{
+		const ModeResult& m = results[r];
+		double worstAlias, meanAlias, worstThdn, meanThdn;
+		summarize(m, worstAlias, meanAlias, worstThdn, meanThdn);
+		fprintf(file,
+			"%s\n    {\"mode\": \"%s\", \"os\": %d, \"phase\": \"%s\", \"split\": %s, \"ns_per_sample\": %.2f, "
+			"\"worst_aliasing_db\": %.2f, \"mean_aliasing_db\": %.2f, \"worst_thdn_db\": %.2f, \"mean_thdn_db\": %.2f, "
+			"\"points\": [",
+			r ? "," : "", modeName(m).c_str(), m.os, m.linear ? "r8b" : "fir", m.split ? "true" : "false",
+			m.nsPerSample, worstAlias, meanAlias, worstThdn, meanThdn);
+		for (size_t i = 0; i < m.points.size(); i++)
+		{
+			const Point& p = m.points[i];
+			fprintf(file, "%s\n      {\"freq\": %.2f, \"drive_db\": %.0f, \"curve\": %.0f, \"thdn_db\": %.2f, \"aliasing_db\": %.2f}",
+			        i ? "," : "", p.freq, p.driveDb, p.curve, p.thdn, p.aliasing);
+		}
+		fprintf(file, "\n    ]}");
+	}
+	fprintf(file, "\n  ]\n}\n");
+}
+
+void writeCsv(FILE* file, const std::vector<ModeResult>& results)
+{
+	fprintf(file, "mode,os,phase,split,ns_per_sample,worst_aliasing_db,mean_aliasing_db,worst_thdn_db,mean_thdn_db\n");
+	for (const ModeResult& m : results)
+	{
+		double worstAlias, meanAlias, worstThdn, meanThdn;
+		summarize(m, worstAlias, meanAlias, worstThdn, meanThdn);
+		fprintf(file, "%s,%d,%s,%d,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+		        modeName(m).c_str(), m.os, m.linear ? "r8b" : "fir", m.split ? 1 : 0,
+		        m.nsPerSample, worstAlias, meanAlias, worstThdn, meanThdn);
+	}
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_quality [options]\n"
+		"  --out FILE            write to FILE instead of stdout\n"
+		"  --csv                 one summary row per mode instead of JSON\n"
+		"  --os LIST             oversampling factors, e.g. 1,2,4,8\n"
+		"  --phase LIST          fir,r8b\n"
+		"  --split LIST          0,1 (default 0)\n"
+		"  --freqs LIST          sine frequencies in Hz\n"
+		"  --drives LIST         input gain in dB, -12..12 (default 0,6,12)\n"
+		"  --curves LIST         curve in %%, -50..50 (default -50,0,50)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --fft N               FFT length, power of two (default 32768)\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--csv") opt.csv = true;
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")    opt.out = v;
+		else if (a == "--os")     opt.os = intList(v);
+		else if (a == "--phase")  opt.linear = boolList(v, "r8b");
+		else if (a == "--split")  opt.split = boolList(v, "split");
+		else if (a == "--freqs")  opt.freqs = intList(v);
+		else if (a == "--drives") opt.drives = intList(v);
+		else if (a == "--curves") opt.curves = intList(v);
+		else if (a == "--rate")   opt.sampleRate = atof(v);
+		else if (a == "--fft")    opt.fftSize = atoi(v);
+		else { usage(); return false; }
+	}
+	if (opt.fftSize < 64 || (opt.fftSize & (opt.fftSize - 1)) != 0)
+	{
+		fprintf(stderr, "jsif_quality: --fft must be a power of two >= 64\n");
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	std::vector<ModeResult> results;
+	for (int os : opt.os)
+	for (bool linear : opt.linear)
+	{
+		// 1x has no oversampler, phase makes no difference
+		if (os == 1 && linear && opt.linear.size() > 1) continue;
+
+		for (bool split : opt.split)
+		{
+			ModeResult m { os, linear, split, 0.0, {} };
+			m.nsPerSample = cost(opt, os, linear, split);
+			for (int freq : opt.freqs)
+			{
+				if (freq <= 0 || freq >= opt.sampleRate / 2) continue;
+				for (int drive : opt.drives)
+				for (int curve : opt.curves)
+					m.points.push_back(measure(opt, os, linear, split, freq,
+					                           std::clamp(drive, -12, 12), std::clamp(curve, -50, 50)));
+			}
+			results.push_back(m);
+		}
+	}
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_quality: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+	if (opt.csv) writeCsv(file, results);
+	else         writeJson(file, opt, results);
+	if (file != stdout) fclose(file);
+	return 0;
+}
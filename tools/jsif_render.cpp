@@ -0,0 +1,956 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_render - renders WAV/RF64 files through the Inflator without a host.
+//
+// Applies the same JSIF_DSP processing the plug-in runs in offline mode
+// (meters off, resamplers created on demand) with every parameter given in
+// the units of the plug-in's controls. The output is 32 or 64 bit float
+// WAV, RF64 once it outgrows 4 GB. The oversampling latency is compensated:
+// the first latency frames are dropped and the input is followed by as many
+// frames of silence, so the output lines up with the input and has the
+// same length. Audio streams through in blocks, memory does not depend on
+// the file length.
+//
+// Input and output are memory mapped where the platform allows: each block
+// is deinterleaved straight from the mapped input and interleaved straight
+// into the mapped output, the output is created at its final size up front.
+// --no-mmap, or a file that cannot be mapped (a pipe), uses stream I/O.
+//
+// Reading, DSP and writing run as a three stage pipeline on their own
+// threads with --queue blocks in flight, --serial runs all three in turn
+// on one thread. Both give the same output.
+//
+// --chunks N renders one file as N chunks on N threads, each with its own
+// JSIF_DSP started a pre-roll early so its state has settled when its
+// chunk begins. In the FIR modes the result is within 1e-9 of a serial
+// render; the r8brain modes were only checked against a stub resampler.
+//
+// --stream filters raw float PCM (--format f32|f64, native byte order)
+// from stdin to stdout in fixed --block blocks, allocation free after
+// start-up. It reports the latency when it starts and the block load when
+// the input ends. An input that ends inside a frame is an error. Denormals
+// are flushed to zero (FTZ/DAZ) while streaming, so where the filter tails
+// decay into them the output can differ slightly from a file render.
+//
+// --batch renders a manifest of files, each with its own parameters, on
+// --jobs worker threads. Every worker keeps one JSIF_DSP for all its files
+// and only resets its state between them, the filters are not set up and
+// the r8brain resamplers not constructed again unless the sample rate,
+// channel count or block size changes. The JSON report gives each file's
+// time and realtime factor and the aggregate throughput.
+//
+//   jsif_render [options] input.wav output.wav
+//   jsif_render [options] --batch manifest.txt [--jobs N] [--report file.json]
+//     --input DB  (-12..12, 0)    --effect PCT (0..100, 0)   --curve PCT (-50..50, 0)
+//     --output DB (-12..0, 0)     --clip  --split            --os 1|2|4|8 (1)
+//     --phase fir|r8b (fir)       --format f32|f64 (f32)     --block N (4096)
+//     --no-compensation           --no-mmap                  --serial
+//     --queue N (4)               --chunks N (1)             --preroll FRAMES
+//     --quiet
+//   jsif_render [options] --stream --channels N --rate HZ < in.raw > out.raw
+//   manifest lines: input.wav output.wav [options], # comments
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_memory.h"
+#include "jsif_pipeline.h"
+#include "jsif_tool_utils.h"
+#include "jsif_wav.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define JSIF_HAVE_SSE_CSR 1
+#else
+#define JSIF_HAVE_SSE_CSR 0
+#endif
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+// Parameters in control units
+struct Settings
+{
+	double inputDb   = 0.0;
+	double effectPct = 0.0;
+	double curvePct  = 0.0;
+	double outputDb  = 0.0;
+	bool   clip      = false;
+	bool   split     = false;
+	int    os        = 1;
+	bool   linear    = false;
+};
+
+struct Options
+{
+	Settings    settings;
+	int32_t     bits       = 32;
+	int32_t     block      = 4096;
+	bool        compensate = true;
+	bool        mmap       = true;
+	bool        serial     = false;
+	int32_t     queue      = 4;       // blocks in flight when pipelined
+	int32_t     chunks     = 1;       // parallel chunks of one file
+	int64_t     preroll    = -1;      // chunk pre-roll frames, -1: JSIF_DSP::getSettleSamples()
+	bool        quiet      = false;
+	std::string inPath, outPath;
+	std::string batchPath, reportPath;
+	int32_t     jobs       = 0;       // batch workers, 0: hardware threads
+	bool        stream     = false;   // raw PCM stdin -> stdout
+	int32_t     channels   = 0;       // stream format
+	double      sampleRate = 0.0;
+};
+
+double clampTo(double value, double lo, double hi) { return std::min(hi, std::max(lo, value)); }
+
+void apply(JSIF_DSP& dsp, const Settings& s)
+{
+	dsp.setInput (clampTo((s.inputDb + 12.0) / 24.0, 0.0, 1.0));
+	dsp.setEffect(clampTo(s.effectPct / 100.0, 0.0, 1.0));
+	dsp.setCurve (clampTo(s.curvePct / 100.0 + 0.5, 0.0, 1.0));
+	dsp.setOutput(clampTo((s.outputDb + 12.0) / 12.0, 0.0, 1.0));
+	dsp.setClip (s.clip);
+	dsp.setSplit(s.split);
+	dsp.setOverSample(toOverSample(s.os));
+	dsp.setLinearPhase(s.linear);
+	dsp.setIn(true);
+	dsp.setBypass(false);
+}
+
+//------------------------------------------------------------------------
+// Latency compensation: the first `latency` processed frames are dropped
+// and the output stops at the input length, the input is followed by
+// silence until then.
+struct Compensation
+{
+	int64_t skip      = 0;
+	int64_t remaining = 0;
+
+	/** Of `frames` processed frames, [offset, offset + count) go to the output. */
+	void take(int64_t frames, int64_t& offset, int64_t& count)
+	{
+		offset = std::min(skip, frames);
+		skip  -= offset;
+		count  = std::min(frames - offset, remaining);
+		remaining -= count;
+	}
+	bool done() const { return remaining <= 0; }
+};
+
+// busy time of each stage, waits excluded
+struct StageTimes
+{
+	double read = 0.0, dsp = 0.0, write = 0.0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------
+// Streams one file through dsp on the calling thread, comp picks the output
+// frames. dsp must be prepared for its format.
+template <typename Reader, typename Writer>
+bool renderSerial(JSIF_DSP& dsp, Reader& reader, Writer& writer, const Options& opt, Compensation comp,
+                  std::string& error, StageTimes& times)
+{
+	using clock = std::chrono::steady_clock;
+	const int32_t channels = reader.format().channels;
+
+	std::vector<std::vector<double>> buffer(channels, std::vector<double>(opt.block));
+	std::vector<double*> ptr(channels);
+	for (int32_t ch = 0; ch < channels; ch++) ptr[ch] = buffer[ch].data();
+
+	while (!comp.done())
+	{
+		auto start = clock::now();
+		int64_t frames = reader.read(ptr.data(), 0, opt.block);
+		if (frames <= 0)
+		{
+			// input exhausted, silence pushes the delayed tail out
+			frames = opt.block;
+			for (auto& channel : buffer) std::fill(channel.begin(), channel.end(), 0.0);
+		}
+		times.read += secondsSince(start);
+
+		start = clock::now();
+		dsp.process(ptr.data(), ptr.data(), channels, (int32_t)frames);
+		times.dsp += secondsSince(start);
+
+		int64_t offset, count;
+		comp.take(frames, offset, count);
+		start = clock::now();
+		if (!writer.write(ptr.data(), offset, count))
+		{
+			error = "write failed";
+			return false;
+		}
+		times.write += secondsSince(start);
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+// The same as a pipeline: read/deinterleave, DSP and interleave/write run on
+// their own threads, so disk I/O and format conversion overlap with the DSP.
+// Blocks come from a fixed pool and circle through three lock-free queues:
+// free -> reader -> filled -> DSP -> processed -> writer -> free.
+struct Block
+{
+	std::vector<std::vector<double>> data;
+	std::vector<double*> ptr;
+	int64_t frames      = 0;
+	int64_t writeOffset = 0;
+	int64_t writeFrames = 0;
+	bool    last        = false;
+};
+
+template <typename Reader, typename Writer>
+bool renderPipelined(JSIF_DSP& dsp, Reader& reader, Writer& writer, const Options& opt, std::string& error, StageTimes& times)
+{
+	using clock = std::chrono::steady_clock;
+	const int32_t channels = reader.format().channels;
+	const int64_t latency  = opt.compensate ? dsp.getLatencySamples() : 0;
+
+	std::vector<Block> pool((size_t)opt.queue);
+	SpscQueue<Block*> freeBlocks(pool.size()), filled(pool.size()), processed(pool.size());
+	for (auto& block : pool)
+	{
+		block.data.assign(channels, std::vector<double>(opt.block));
+		for (auto& channel : block.data) block.ptr.push_back(channel.data());
+		freeBlocks.push(&block);
+	}
+
+	std::atomic<bool> abort { false };
+	bool writeFailed = false;
+
+	std::thread readStage([&] {
+		// the input plus the silence that flushes the latency
+		int64_t toFeed = (int64_t)reader.frames() + latency;
+		do {
+			Block* block = nullptr;
+			if (!popWait(freeBlocks, block, abort)) return;
+			auto start = clock::now();
+			int64_t frames = std::min<int64_t>(opt.block, toFeed);
+			int64_t got = std::max<int64_t>(0, reader.read(block->ptr.data(), 0, frames));
+			for (auto& channel : block->data)
+				std::fill(channel.begin() + got, channel.begin() + frames, 0.0);
+			toFeed -= frames;
+			block->frames = frames;
+			block->last   = (toFeed <= 0);
+			times.read += secondsSince(start);
+			if (!pushWait(filled, block, abort)) return;
+		} while (toFeed > 0);
+	});
+
+	std::thread writeStage([&] {
+		while (true)
+		{
+			Block* block = nullptr;
+			if (!popWait(processed, block, abort)) return;
+			auto start = clock::now();
+			if (!writer.write(block->ptr.data(), block->writeOffset, block->writeFrames))
+			{
+				writeFailed = true;
+				abort = true;
+				return;
+			}
+			times.write += secondsSince(start);
+			bool last = block->last;
+			if (last || !pushWait(freeBlocks, block, abort)) return;
+		}
+	});
+
+	Compensation comp { latency, (int64_t)reader.frames() };
+	while (true)
+	{
+		Block* block = nullptr;
+		if (!popWait(filled, block, abort)) break;
+		auto start = clock::now();
+		if (block->frames > 0)
+			dsp.process(block->ptr.data(), block->ptr.data(), channels, (int32_t)block->frames);
+		comp.take(block->frames, block->writeOffset, block->writeFrames);
+		times.dsp += secondsSince(start);
+		bool last = block->last;
+		if (!pushWait(processed, block, abort) || last) break;
+	}
+
+	readStage.join();
+	writeStage.join();
+	if (writeFailed) error = "write failed";
+	return !writeFailed;
+}
+
+template <typename Reader, typename Writer>
+bool render(JSIF_DSP& dsp, Reader& reader, Writer& writer, const Options& opt, std::string& error, StageTimes& times)
+{
+	Compensation comp { opt.compensate ? dsp.getLatencySamples() : 0, (int64_t)reader.frames() };
+	return opt.serial ? renderSerial(dsp, reader, writer, opt, comp, error, times)
+	                  : renderPipelined(dsp, reader, writer, opt, error, times);
+}
+
+//------------------------------------------------------------------------
+// A JSIF_DSP in the plug-in's offline setup (meters off, resamplers created
+// on demand) that stays alive from file to file: it is prepared again only
+// when the format or block size changes, otherwise reset() clears its state
+// and the filters, resamplers and latency rings are reused as they are.
+struct Engine
+{
+	JSIF_DSP dsp;
+	double   sampleRate = 0.0;
+	int32_t  channels   = 0;
+	int32_t  block      = 0;
+	int      prepares   = 0;
+
+	/** True when the instance was reused with a reset, false when prepared. */
+	bool setup(const WavFormat& format, int32_t newBlock)
+	{
+		if (format.sampleRate == sampleRate && format.channels == channels && newBlock == block)
+		{
+			dsp.reset();
+			return true;
+		}
+		dsp.setLowFootprint(true);
+		dsp.prepare(format.sampleRate, format.channels, newBlock);
+		dsp.setMetering(false);
+		sampleRate = format.sampleRate;
+		channels   = format.channels;
+		block      = newBlock;
+		prepares++;
+		return false;
+	}
+};
+
+struct FileResult
+{
+	WavFormat   format;
+	uint64_t    frames  = 0;
+	int32_t     latency = 0;
+	bool        mapped  = false;
+	bool        reused  = false;
+	int32_t     chunks  = 1;
+	int64_t     preroll = 0;
+	double      seconds = 0.0;
+	StageTimes  times;
+	std::string error;
+};
+
+//------------------------------------------------------------------------
+// One file in parallel chunks: the output is cut into --chunks ranges, each
+// rendered on its own thread by its own Engine, reading its own mapping of
+// the input and writing straight into its range of the mapped output. A
+// fresh instance has no history, so each chunk starts pre-roll frames
+// early, JSIF_DSP::getSettleSamples() by default, and drops that output.
+// After it the filter, resampler, latency ring and band split state match
+// a serial render's. In the FIR modes the output differs from it by less
+// than 1e-9 (checked by jsif_golden), below the resolution of the float
+// output. The error of the r8brain modes depends on how far the resampler's
+// own filter state has settled and has not been measured with the library.
+struct RangeWriter
+{
+	MappedWavWriter& file;
+	uint64_t frame;
+	uint64_t released = frame;
+
+	bool write(const double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!file.writeAt(frame, planar, offset, frames)) return false;
+		frame += (uint64_t)frames;
+		if ((frame - released) * (uint64_t)file.format().blockAlign >= MappedWavWriter::kReleaseBytes)
+		{
+			file.releaseFrames(released, frame - released);
+			released = frame;
+		}
+		return true;
+	}
+};
+
+bool renderChunked(Engine& engine, const Options& opt, MappedWavWriter& writer, FileResult& result, std::string& error)
+{
+	const uint64_t total   = result.frames;
+	const int64_t  preroll = opt.preroll >= 0 ? opt.preroll : engine.dsp.getSettleSamples();
+
+	// chunks much shorter than the pre-roll spend more time settling than they save
+	uint64_t shortest = 4 * (uint64_t)std::max<int64_t>(preroll, opt.block);
+	size_t   chunks   = (size_t)std::max<uint64_t>(1, std::min<uint64_t>((uint64_t)opt.chunks, total / shortest));
+
+	std::vector<StageTimes>  times(chunks);
+	std::vector<std::string> errors(chunks);
+	std::vector<char>        ok(chunks, 0);
+
+	auto renderChunk = [&](size_t n, Engine& chunkEngine) {
+		uint64_t first = total * n / chunks;
+		uint64_t last  = total * (n + 1) / chunks;
+		uint64_t start = first - std::min<uint64_t>(first, (uint64_t)preroll);
+
+		MappedWavReader reader;
+		if (!reader.open(opt.inPath, errors[n]) || !reader.seek(start)) return;
+		if (&chunkEngine != &engine)
+		{
+			chunkEngine.setup(result.format, opt.block);
+			apply(chunkEngine.dsp, opt.settings);
+		}
+		RangeWriter range { writer, first };
+		Compensation comp { (int64_t)(first - start) + result.latency, (int64_t)(last - first) };
+		ok[n] = renderSerial(chunkEngine.dsp, reader, range, opt, comp, errors[n], times[n]);
+	};
+
+	// the first chunk has no pre-roll and runs on the caller's engine
+	std::vector<std::unique_ptr<Engine>> engines;
+	std::vector<std::thread> threads;
+	for (size_t n = 1; n < chunks; n++)
+	{
+		engines.emplace_back(new Engine());
+		threads.emplace_back(renderChunk, n, std::ref(*engines.back()));
+	}
+	renderChunk(0, engine);
+	for (auto& thread : threads) thread.join();
+
+	result.chunks  = (int32_t)chunks;
+	result.preroll = preroll;
+	for (size_t n = 0; n < chunks; n++)
+	{
+		result.times.read  += times[n].read;
+		result.times.dsp   += times[n].dsp;
+		result.times.write += times[n].write;
+		if (!ok[n])
+		{
+			error = errors[n].empty() ? "write failed" : errors[n];
+			return false;
+		}
+	}
+	writer.setWritten(total);
+	return true;
+}
+
+// Renders opt.inPath to opt.outPath with engine.
+bool renderFile(Engine& engine, const Options& opt, FileResult& result)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	WavReader reader;
+	if (!reader.open(opt.inPath, result.error))
+	{
+		result.error = opt.inPath + ": " + result.error;
+		return false;
+	}
+	result.format = reader.format();
+	result.frames = reader.frames();
+	result.reused = engine.setup(result.format, opt.block);
+
+	JSIF_DSP& dsp = engine.dsp;
+	apply(dsp, opt.settings);
+	result.latency = opt.compensate ? dsp.getLatencySamples() : 0;
+
+	const WavFormat& format = result.format;
+	std::string error;
+	bool ok = false;
+	if (opt.mmap && MappedFile::supported())
+	{
+		MappedWavReader mappedReader;
+		MappedWavWriter mappedWriter;
+		std::string mapError;
+		if (mappedReader.open(opt.inPath, mapError) &&
+		    mappedWriter.open(opt.outPath, format.channels, format.sampleRate, opt.bits, result.frames, mapError))
+		{
+			reader.close();
+			result.mapped = true;
+			if (opt.chunks > 1)
+				ok = renderChunked(engine, opt, mappedWriter, result, error);
+			else
+				ok = render(dsp, mappedReader, mappedWriter, opt, error, result.times);
+			ok &= mappedWriter.close();
+		}
+	}
+	if (!result.mapped)
+	{
+		WavWriter writer;
+		if (!writer.open(opt.outPath, format.channels, format.sampleRate, opt.bits, error))
+		{
+			result.error = error;
+			return false;
+		}
+		ok = render(dsp, reader, writer, opt, error, result.times);
+		ok &= writer.close();
+	}
+	if (!ok)
+	{
+		result.error = opt.outPath + ": " + (error.empty() ? "write failed" : error);
+		return false;
+	}
+	result.seconds = secondsSince(start);
+	return true;
+}
+
+//------------------------------------------------------------------------
+// Batch mode: the manifest lists one file per line as
+//
+//   input.wav output.wav [options]
+//
+// with the options of the command line, which set the defaults for every
+// line. Blank lines and lines starting with # are skipped, paths with
+// spaces go in double quotes. --jobs workers take the files in manifest
+// order, each with its own Engine.
+struct Job
+{
+	Options    opt;
+	int        line   = 0;
+	int        worker = -1;
+	bool       ok     = false;
+	FileResult result;
+};
+
+std::vector<std::string> tokenize(const std::string& line)
+{
+	std::vector<std::string> tokens;
+	size_t i = 0;
+	while (i < line.size())
+	{
+		if (isspace((unsigned char)line[i])) { i++; continue; }
+		std::string token;
+		if (line[i] == '"')
+		{
+			size_t end = line.find('"', i + 1);
+			if (end == std::string::npos) end = line.size();
+			token = line.substr(i + 1, end - i - 1);
+			i = end + 1;
+		}
+		else
+		{
+			while (i < line.size() && !isspace((unsigned char)line[i])) token += line[i++];
+		}
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+std::string jsonString(const std::string& s)
+{
+	std::string out = "\"";
+	for (char c : s)
+	{
+		if      (c == '"' || c == '\\') { out += '\\'; out += c; }
+		else if ((unsigned char)c < 0x20) { char b[8]; snprintf(b, sizeof(b), "\\u%04x", c); out += b; }
+		else out += c;
+	}
+	return out + "\"";
+}
+
+//------------------------------------------------------------------------
+// Stream mode: raw interleaved float PCM from stdin to stdout, for Unix
+// pipes and ffmpeg (-f f32le / f64le). Every block is --block frames, the
+// last one padded with silence, so the DSP always sees the same work. All
+// buffers are allocated and the resamplers warmed up before the first
+// read, stdio is unbuffered so it allocates nothing either, and denormals
+// are flushed to zero: the band split and filter tails decay into them
+// whenever the input goes quiet. The latency is reported on stderr at the
+// start, the per block load at the end.
+struct DenormalsOff
+{
+#if JSIF_HAVE_SSE_CSR
+	unsigned int saved = _mm_getcsr();
+	DenormalsOff()  { _mm_setcsr(saved | 0x8040); }  // FTZ | DAZ
+	~DenormalsOff() { _mm_setcsr(saved); }
+#endif
+};
+
+// DSP time per block against the block period, in 1 % steps
+struct LoadStats
+{
+	static constexpr int kBins = 201;   // the last one collects everything from 200 % up
+	long long bins[kBins] = {};
+	long long blocks   = 0;
+	long long overruns = 0;
+	double    sum = 0.0, max = 0.0;
+
+	void add(double load)
+	{
+		bins[std::min(kBins - 1, (int)(load * 100.0))]++;
+		blocks++;
+		overruns += (load > 1.0);
+		sum += load;
+		max  = std::max(max, load);
+	}
+
+	double percentile(double p) const
+	{
+		long long target = (long long)std::ceil(p * (double)blocks), seen = 0;
+		for (int i = 0; i < kBins; i++)
+			if ((seen += bins[i]) >= target && target > 0) return (i + 1) / 100.0;
+		return 0.0;
+	}
+};
+
+int renderStream(const Options& opt)
+{
+	if (opt.channels < 1 || opt.sampleRate <= 0.0)
+	{
+		fprintf(stderr, "jsif_render: --stream needs --channels and --rate\n");
+		return 1;
+	}
+#ifdef _WIN32
+	_setmode(_fileno(stdin),  _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	setvbuf(stdin,  nullptr, _IONBF, 0);
+	setvbuf(stdout, nullptr, _IONBF, 0);
+
+	const WavFormat format = wav::floatFormat(opt.channels, opt.sampleRate, opt.bits);
+	const int32_t   block  = opt.block;
+
+	Engine engine;
+	engine.setup(format, block);
+	JSIF_DSP& dsp = engine.dsp;
+	apply(dsp, opt.settings);
+	const int32_t latency = dsp.getLatencySamples();
+
+	std::vector<uint8_t> in ((size_t)block * format.blockAlign);
+	std::vector<uint8_t> out((size_t)block * format.blockAlign);
+	std::vector<std::vector<double>> buffer(format.channels, std::vector<double>(block, 0.0));
+	std::vector<double*> ptr(format.channels);
+	for (int32_t ch = 0; ch < format.channels; ch++) ptr[ch] = buffer[ch].data();
+
+	// the first blocks of a mode create its resamplers and grow their buffers, do that now
+	for (int64_t warm = 0; warm < latency + 4 * (int64_t)block; warm += block)
+		dsp.process(ptr.data(), ptr.data(), format.channels, block);
+	dsp.reset();
+	for (auto& channel : buffer) std::fill(channel.begin(), channel.end(), 0.0);
+
+	const double period = (double)block / format.sampleRate;
+	if (!opt.quiet)
+		fprintf(stderr, "jsif_render: stream %d ch, %.0f Hz, f%d, block %d, latency %d frames%s + %d frames block = %.2f ms\n",
+		        format.channels, format.sampleRate, format.bits, block, latency,
+		        (opt.compensate && latency > 0) ? " (compensated)" : "", block, 1000.0 * (latency + block) / format.sampleRate);
+
+	DenormalsOff denormalsOff;
+	const uint64_t heapStart = heapBytes();
+	LoadStats load;
+
+	// the output length is only known at the end of the input
+	Compensation comp { opt.compensate ? latency : 0, INT64_MAX };
+	int64_t read = 0, written = 0;
+	bool eof = false, failed = false;
+	size_t partial = 0;   // bytes of a frame cut off by the end of the input
+	while (!comp.done())
+	{
+		size_t got = 0;
+		if (!eof)
+		{
+			// whole blocks read by byte count, so a cut-off last frame is seen
+			const size_t bytes = fread(in.data(), 1, in.size(), stdin);
+			got     = bytes / format.blockAlign;
+			partial = bytes % format.blockAlign;
+			if (got < (size_t)block)
+			{
+				eof    = true;
+				failed = ferror(stdin) != 0;
+				comp.remaining = read + (int64_t)got - written;
+			}
+			read += (int64_t)got;
+		}
+		wav::decode(in.data(), format, ptr.data(), 0, (int64_t)got);
+		for (auto& channel : buffer) std::fill(channel.begin() + got, channel.end(), 0.0);
+
+		auto start = std::chrono::steady_clock::now();
+		dsp.process(ptr.data(), ptr.data(), format.channels, block);
+		load.add(secondsSince(start) / period);
+
+		int64_t offset, count;
+		comp.take(block, offset, count);
+		wav::encode(ptr.data(), offset, count, format.channels, format.bits, out.data());
+		if (fwrite(out.data(), format.blockAlign, (size_t)count, stdout) != (size_t)count)
+		{
+			failed = true;
+			break;
+		}
+		written += count;
+	}
+	fflush(stdout);
+
+	const int64_t heapGrowth = (int64_t)heapBytes() - (int64_t)heapStart;
+	if (!opt.quiet)
+		fprintf(stderr, "jsif_render: stream %lld frames in, %lld out, %lld blocks, load mean %.1f %%, p99 %.0f %%, max %.1f %%, "
+		                "%lld overruns, heap %+lld bytes since start-up\n",
+		        (long long)read, (long long)written, load.blocks, load.blocks ? 100.0 * load.sum / load.blocks : 0.0,
+		        100.0 * load.percentile(0.99), 100.0 * load.max, load.overruns, (long long)heapGrowth);
+	if (failed)
+	{
+		fprintf(stderr, "jsif_render: stream %s failed\n", ferror(stdin) ? "read" : "write");
+		return 1;
+	}
+	if (partial)
+	{
+		fprintf(stderr, "jsif_render: stream input ends with a partial frame, %zu of %d bytes dropped\n",
+		        partial, format.blockAlign);
+		return 1;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_render [options] input.wav output.wav\n"
+		"       jsif_render [options] --batch manifest.txt [--jobs N] [--report file.json]\n"
+		"  --input DB            input gain, -12..12 dB (default 0)\n"
+		"  --effect PCT          dry/wet, 0..100 %% (default 0)\n"
+		"  --curve PCT           curve, -50..50 %% (default 0)\n"
+		"  --output DB           output gain, -12..0 dB (default 0)\n"
+		"  --clip                clip at 0 dBFS\n"
+		"  --split               3 band split\n"
+		"  --os N                oversampling, 1, 2, 4 or 8 (default 1)\n"
+		"  --phase fir|r8b       minimum phase FIR or linear phase r8brain (default fir)\n"
+		"  --format f32|f64      output sample format (default f32)\n"
+		"  --block N             frames per block (default 4096)\n"
+		"  --no-compensation     keep the oversampling latency in the output\n"
+		"  --no-mmap             stream I/O instead of memory mapped files\n"
+		"  --serial              read, process and write on one thread\n"
+		"  --queue N             blocks in flight between the pipeline stages (default 4)\n"
+		"  --chunks N            render the file as N chunks on N threads (memory mapped I/O only)\n"
+		"  --preroll FRAMES      pre-roll per chunk (default: JSIF_DSP::getSettleSamples())\n"
+		"  --quiet               no summary on stderr\n"
+		"  --batch FILE          render the files listed in FILE, one 'input output [options]' per line\n"
+		"  --jobs N              batch worker threads (default: hardware threads)\n"
+		"  --report FILE         write the batch JSON report to FILE instead of stdout\n"
+		"  --stream              raw interleaved PCM (--format) from stdin to stdout\n"
+		"  --channels N          stream channels\n"
+		"  --rate HZ             stream sample rate\n");
+}
+
+// Options from args into opt, the file names into files. Manifest lines cannot start another batch.
+bool parseArgs(const std::vector<std::string>& args, Options& opt, std::vector<std::string>& files, bool manifest)
+{
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		const std::string& a = args[i];
+		auto next = [&]() -> const char* { return (i + 1 < args.size()) ? args[++i].c_str() : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if (a == "--clip")            opt.settings.clip = true;
+		else if (a == "--split")           opt.settings.split = true;
+		else if (a == "--no-compensation") opt.compensate = false;
+		else if (a == "--no-mmap")         opt.mmap = false;
+		else if (a == "--serial")          opt.serial = true;
+		else if (a == "--quiet")           opt.quiet = true;
+		else if (a == "--stream" && !manifest) opt.stream = true;
+		else if (a.compare(0, 2, "--") != 0) files.push_back(a);
+		else if ((v = next()) == nullptr) return false;
+		else if (a == "--input")  opt.settings.inputDb   = atof(v);
+		else if (a == "--effect") opt.settings.effectPct = atof(v);
+		else if (a == "--curve")  opt.settings.curvePct  = atof(v);
+		else if (a == "--output") opt.settings.outputDb  = atof(v);
+		else if (a == "--os")     opt.settings.os        = atoi(v);
+		else if (a == "--phase")  opt.settings.linear    = (std::string(v) == "r8b" || std::string(v) == "linear");
+		else if (a == "--format") opt.bits  = (std::string(v) == "f64") ? 64 : 32;
+		else if (a == "--block")  opt.block = std::max(1, atoi(v));
+		else if (a == "--queue")  opt.queue = std::max(2, atoi(v));
+		else if (a == "--chunks") opt.chunks = std::max(1, atoi(v));
+		else if (a == "--preroll") opt.preroll = std::max(0, atoi(v));
+		else if (manifest) return false;
+		else if (a == "--batch")  opt.batchPath  = v;
+		else if (a == "--jobs")   opt.jobs       = std::max(1, atoi(v));
+		else if (a == "--report") opt.reportPath = v;
+		else if (a == "--channels") opt.channels   = atoi(v);
+		else if (a == "--rate")     opt.sampleRate = atof(v);
+		else return false;
+	}
+	return true;
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	std::vector<std::string> files;
+	if (!parseArgs(std::vector<std::string>(argv + 1, argv + argc), opt, files, false) ||
+	    files.size() != ((opt.batchPath.empty() && !opt.stream) ? 2u : 0u))
+	{
+		usage();
+		return false;
+	}
+	if (opt.batchPath.empty() && !opt.stream)
+	{
+		opt.inPath  = files[0];
+		opt.outPath = files[1];
+	}
+	return true;
+}
+
+bool readManifest(const Options& defaults, std::vector<Job>& jobs)
+{
+	std::ifstream file(defaults.batchPath);
+	if (!file)
+	{
+		fprintf(stderr, "jsif_render: cannot open %s\n", defaults.batchPath.c_str());
+		return false;
+	}
+	std::string line;
+	for (int number = 1; std::getline(file, line); number++)
+	{
+		std::vector<std::string> tokens = tokenize(line);
+		if (tokens.empty() || tokens[0][0] == '#')
+			continue;
+
+		Job job;
+		job.opt  = defaults;
+		job.line = number;
+		std::vector<std::string> files;
+		if (!parseArgs(tokens, job.opt, files, true) || files.size() != 2)
+		{
+			fprintf(stderr, "jsif_render: %s:%d: expected 'input output [options]'\n", defaults.batchPath.c_str(), number);
+			return false;
+		}
+		job.opt.inPath  = files[0];
+		job.opt.outPath = files[1];
+		// the workers already keep every core busy
+		job.opt.serial  = true;
+		job.opt.chunks  = 1;
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------
+int renderBatch(const Options& opt)
+{
+	std::vector<Job> jobs;
+	if (!readManifest(opt, jobs))
+		return 1;
+
+	int workers = opt.jobs > 0 ? opt.jobs : (int)std::max(1u, std::thread::hardware_concurrency());
+	workers = std::max(1, std::min<int>(workers, (int)jobs.size()));
+
+	std::vector<int> prepares(workers, 0);
+	std::atomic<size_t> nextJob { 0 };
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (int w = 0; w < workers; w++)
+		threads.emplace_back([&, w] {
+			Engine engine;
+			for (size_t j; (j = nextJob.fetch_add(1)) < jobs.size(); )
+			{
+				Job& job = jobs[j];
+				job.worker = w;
+				job.ok = renderFile(engine, job.opt, job.result);
+				if (!job.ok && !opt.quiet)
+					fprintf(stderr, "jsif_render: %s\n", job.result.error.c_str());
+			}
+			prepares[w] = engine.prepares;
+		});
+	for (auto& thread : threads) thread.join();
+
+	const double wall = secondsSince(start);
+
+	FILE* report = stdout;
+	if (!opt.reportPath.empty() && (report = fopen(opt.reportPath.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_render: cannot open %s\n", opt.reportPath.c_str());
+		return 1;
+	}
+
+	fprintf(report, "{\n  \"tool\": \"jsif_render\",\n  \"manifest\": %s,\n  \"jobs\": %d,\n  \"files\": [",
+	        jsonString(opt.batchPath).c_str(), workers);
+
+	int failed = 0, totalPrepares = 0;
+	double audio = 0.0, busy = 0.0, bytes = 0.0;
+	uint64_t frames = 0;
+	for (size_t j = 0; j < jobs.size(); j++)
+	{
+		const Job& job = jobs[j];
+		const FileResult& r = job.result;
+		double seconds = r.format.sampleRate > 0.0 ? (double)r.frames / r.format.sampleRate : 0.0;
+
+		fprintf(report, "%s\n    {\"line\": %d, \"input\": %s, \"output\": %s, \"ok\": %s",
+		        j ? "," : "", job.line, jsonString(job.opt.inPath).c_str(), jsonString(job.opt.outPath).c_str(),
+		        job.ok ? "true" : "false");
+		if (job.ok)
+		{
+			fprintf(report, ", \"worker\": %d, \"reused\": %s, \"frames\": %llu, \"channels\": %d, \"sample_rate\": %.0f, "
+			                "\"audio_seconds\": %.3f, \"seconds\": %.4f, \"realtime\": %.1f, \"mmap\": %s}",
+			        job.worker, r.reused ? "true" : "false", (unsigned long long)r.frames, r.format.channels,
+			        r.format.sampleRate, seconds, r.seconds, r.seconds > 0.0 ? seconds / r.seconds : 0.0,
+			        r.mapped ? "true" : "false");
+			audio  += seconds;
+			busy   += r.seconds;
+			frames += r.frames;
+			bytes  += (double)r.frames * r.format.blockAlign;
+		}
+		else
+		{
+			fprintf(report, ", \"error\": %s}", jsonString(r.error).c_str());
+			failed++;
+		}
+	}
+	for (int p : prepares) totalPrepares += p;
+
+	// realtime against the wall clock is the batch throughput, against the
+	// summed file times it is what one worker achieves
+	fprintf(report, "\n  ],\n  \"aggregate\": {\"files\": %zu, \"failed\": %d, \"frames\": %llu, \"audio_seconds\": %.3f, "
+	                "\"wall_seconds\": %.3f, \"realtime\": %.1f, \"realtime_per_worker\": %.1f, "
+	                "\"files_per_second\": %.1f, \"input_mb_per_second\": %.1f, \"prepares\": %d}\n}\n",
+	        jobs.size(), failed, (unsigned long long)frames, audio, wall,
+	        wall > 0.0 ? audio / wall : 0.0, busy > 0.0 ? audio / busy : 0.0,
+	        wall > 0.0 ? (double)(jobs.size() - failed) / wall : 0.0,
+	        wall > 0.0 ? bytes / wall / (1024.0 * 1024.0) : 0.0, totalPrepares);
+	if (report != stdout) fclose(report);
+	return failed ? 1 : 0;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	if (!opt.batchPath.empty())
+		return renderBatch(opt);
+	if (opt.stream)
+		return renderStream(opt);
+
+	Engine engine;
+	FileResult result;
+	if (!renderFile(engine, opt, result))
+	{
+		fprintf(stderr, "jsif_render: %s\n", result.error.c_str());
+		return 1;
+	}
+
+	double audio = (double)result.frames / result.format.sampleRate;
+	std::string mode = opt.serial ? "serial" : "pipelined";
+	if (result.chunks > 1)
+		mode = std::to_string(result.chunks) + " chunks, pre-roll " + std::to_string(result.preroll);
+	if (!opt.quiet)
+		fprintf(stderr, "jsif_render: %s -> %s, %llu frames, %d ch, %.0f Hz, latency %d, %s, %s, %.2f s, %.1fx realtime "
+		                "(read %.2f s, dsp %.2f s, write %.2f s)\n",
+		        opt.inPath.c_str(), opt.outPath.c_str(), (unsigned long long)result.frames, result.format.channels,
+		        result.format.sampleRate, result.latency, result.mapped ? "mmap" : "stream",
+		        mode.c_str(), result.seconds, result.seconds > 0.0 ? audio / result.seconds : 0.0,
+		        result.times.read, result.times.dsp, result.times.write);
+	return 0;
+}
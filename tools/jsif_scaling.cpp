@@ -0,0 +1,298 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_scaling - per-instance cost of JSIF_DSP as the instance count grows.
+//
+// A DAW calls every plug-in instance once per audio callback, one after the
+// other, each with its own track buffers. This runs 1 to 256 instances that
+// way: every callback refills each instance's input from its own position
+// in a one second loop (not timed, like the tracks the host reads), then
+// times process() on all instances in turn. Single instance benchmarks keep
+// the whole working set in cache, here the filter state, latency rings and
+// r8brain buffers of all instances compete for the caches, and the cost per
+// instance rises once their sum no longer fits the last level cache.
+//
+// Each row gives the mean and p99 callback time divided by the instance
+// count, ns per channel sample, the cost relative to one instance, the
+// callback load against the block deadline, and the estimated working set
+// (JSIF_DSP::getMemoryReport() plus I/O buffers per instance) next to the
+// last level cache size. The FIR coefficient tables are shared by all
+// instances and counted once. On Linux LLC misses per sample are added
+// when perf_event_open is permitted.
+//
+//   jsif_scaling [--quick] [--out file.json] [--counts 1,2,4,...,256]
+//                [--blocks 64,128,256,512] [--os 1,2,4,8] [--phase fir,r8b]
+//                [--channels N] [--rate HZ] [--seconds S] [--low-footprint]
+//                [--no-counters]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_memory.h"
+#include "jsif_perf_counters.h"
+#include "jsif_tool_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+//------------------------------------------------------------------------
+struct Options
+{
+	std::vector<int>  counts       = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+	std::vector<int>  blocks       = { 64, 128, 256, 512 };
+	std::vector<int>  os           = { 1, 4 };
+	std::vector<bool> linear       = { false, true };
+	int               channels     = 2;
+	double            sampleRate   = 48000.0;
+	double            seconds      = 0.25;  // audio per instance and run
+	int               minCallbacks = 64;
+	bool              lowFootprint = false;
+	PerfCounters*     counters     = nullptr;
+	std::string       out;
+};
+
+struct Result
+{
+	long long callbacks = 0;
+	double meanNs = 0.0;       // per instance and callback
+	double p99Ns  = 0.0;
+	double maxLoad = 0.0;      // slowest callback / deadline
+	double instanceKb = 0.0;   // getMemoryReport().total()
+	double ioKb       = 0.0;
+	double sharedKb   = 0.0;
+	PerfCounters::Values counters;
+	double countedSamples = 0.0;
+};
+
+// one plug-in slot with its own track buffers
+struct Slot
+{
+	std::unique_ptr<JSIF_DSP> dsp;
+	std::vector<std::vector<float>> in, out;
+	std::vector<float*> inPtr, outPtr;
+	size_t position = 0;
+};
+
+//------------------------------------------------------------------------
+Result run(const Options& opt, const std::vector<std::vector<float>>& source, int count, int os, bool linear, int block)
+{
+	using clock = std::chrono::steady_clock;
+
+	const int    channels = opt.channels;
+	const size_t loop     = source.front().size();
+
+	std::vector<Slot> slots(count);
+	for (int n = 0; n < count; n++)
+	{
+		Slot& s = slots[n];
+		s.dsp.reset(new JSIF_DSP());
+		s.dsp->setLowFootprint(opt.lowFootprint);
+		s.dsp->prepare(opt.sampleRate, channels, block);
+		s.dsp->setInput(0.5);
+		s.dsp->setEffect(1.0);
+		s.dsp->setCurve(0.5);
+		s.dsp->setOutput(1.0);
+		s.dsp->setOverSample(toOverSample(os));
+		s.dsp->setLinearPhase(linear);
+		s.dsp->setIn(true);
+
+		s.in .assign(channels, std::vector<float>(block));
+		s.out.assign(channels, std::vector<float>(block));
+		s.inPtr.resize(channels);
+		s.outPtr.resize(channels);
+		for (int ch = 0; ch < channels; ch++)
+		{
+			s.inPtr [ch] = s.in [ch].data();
+			s.outPtr[ch] = s.out[ch].data();
+		}
+		// tracks play different material, spread the start positions over the loop
+		s.position = (loop / (size_t)count) * (size_t)n;
+	}
+
+	auto refill = [&](Slot& s) {
+		for (int ch = 0; ch < channels; ch++)
+			for (int i = 0; i < block; i++)
+				s.in[ch][i] = source[ch][(s.position + i) % loop];
+		s.position = (s.position + block) % loop;
+	};
+
+	// warm up, r8brain allocates part of its buffers on the first calls
+	for (int i = 0; i < 4; i++)
+		for (auto& s : slots)
+		{
+			refill(s);
+			s.dsp->process(s.inPtr.data(), s.outPtr.data(), channels, block);
+		}
+
+	const long long callbacks = std::max<long long>(opt.minCallbacks, (long long)(opt.seconds * opt.sampleRate / block));
+	std::vector<double> times;
+	times.reserve((size_t)callbacks);
+
+	Result r;
+	for (long long call = 0; call < callbacks; call++)
+	{
+		for (auto& s : slots) refill(s);
+
+		if (opt.counters) opt.counters->start();
+		auto start = clock::now();
+		for (auto& s : slots)
+			s.dsp->process(s.inPtr.data(), s.outPtr.data(), channels, block);
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+		if (opt.counters)
+		{
+			PerfCounters::Values v = opt.counters->stop();
+			for (int i = 0; i < PerfCounters::kNumCounters; i++)
+			{
+				r.counters.valid[i] |= v.valid[i];
+				r.counters.count[i] += v.count[i];
+			}
+		}
+		times.push_back(ns);
+	}
+
+	double sum = 0.0;
+	for (double t : times) sum += t;
+	std::sort(times.begin(), times.end());
+	size_t p99 = std::min(times.size() - 1, (size_t)((double)times.size() * 0.99));
+
+	r.callbacks      = callbacks;
+	r.meanNs         = sum / (double)times.size() / (double)count;
+	r.p99Ns          = times[p99] / (double)count;
+	r.maxLoad        = times.back() / (1e9 * (double)block / opt.sampleRate);
+	r.countedSamples = (double)callbacks * (double)count * (double)block * (double)channels;
+
+	JSIF_DSP::MemoryReport memory = slots.front().dsp->getMemoryReport();
+	r.instanceKb = (double)memory.total() / 1024.0;
+	r.sharedKb   = (double)memory.shared / 1024.0;
+	r.ioKb       = 2.0 * channels * block * sizeof(float) / 1024.0;
+	return r;
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_scaling [options]\n"
+		"  --out FILE            write JSON to FILE instead of stdout\n"
+		"  --quick               fewer counts and block sizes for a fast sanity run\n"
+		"  --counts LIST         instance counts (default 1,2,4,8,16,32,64,128,256)\n"
+		"  --blocks LIST         block sizes (default 64,128,256,512)\n"
+		"  --os LIST             oversampling factors (default 1,4)\n"
+		"  --phase LIST          fir,r8b\n"
+		"  --channels N          channels per instance (default 2)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --seconds S           audio seconds per run (default 0.25)\n"
+		"  --low-footprint       instances use JSIF_DSP::setLowFootprint()\n"
+		"  --no-counters         skip the hardware counters\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt, bool& useCounters)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--quick") {
+			opt.counts = { 1, 16, 128 }; opt.blocks = { 128 };
+			opt.seconds = 0.1; opt.minCallbacks = 16;
+		}
+		else if (a == "--low-footprint") opt.lowFootprint = true;
+		else if (a == "--no-counters")   useCounters = false;
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")       opt.out = v;
+		else if (a == "--counts")    opt.counts = intList(v);
+		else if (a == "--blocks")    opt.blocks = intList(v);
+		else if (a == "--os")        opt.os = intList(v);
+		else if (a == "--phase")     opt.linear = boolList(v, "r8b");
+		else if (a == "--channels")  opt.channels = std::max(1, atoi(v));
+		else if (a == "--rate")      opt.sampleRate = atof(v);
+		else if (a == "--seconds")   opt.seconds = atof(v);
+		else { usage(); return false; }
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	bool useCounters = true;
+	if (!parse(argc, argv, opt, useCounters))
+		return 1;
+
+	PerfCounters counters;
+	if (useCounters)
+	{
+		if (counters.available())
+			opt.counters = &counters;
+		else
+			fprintf(stderr, "jsif_scaling: hardware counters unavailable, reporting wall clock only\n");
+	}
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_scaling: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+
+	std::vector<std::vector<float>> source(opt.channels, std::vector<float>((size_t)opt.sampleRate));
+	fillSignal(source, opt.sampleRate);
+
+	fprintf(file, "{\n  \"tool\": \"jsif_scaling\",\n  \"sample_rate\": %.1f,\n  \"channels\": %d,\n"
+	              "  \"low_footprint\": %s,\n  \"llc_kb\": %.1f,\n  \"results\": [",
+	        opt.sampleRate, opt.channels, opt.lowFootprint ? "true" : "false", (double)lastLevelCacheBytes() / 1024.0);
+
+	bool first = true;
+	for (int os : opt.os)
+	for (bool linear : opt.linear)
+	{
+		// 1x has no oversampler, phase makes no difference
+		if (os == 1 && linear && opt.linear.size() > 1) continue;
+
+		for (int block : opt.blocks)
+		{
+			if (block < 1) continue;
+			double single = 0.0;
+			for (int count : opt.counts)
+			{
+				if (count < 1) continue;
+				Result r = run(opt, source, count, os, linear, block);
+				if (single <= 0.0) single = r.meanNs;
+
+				fprintf(file,
+					"%s\n    {\"os\": %d, \"phase\": \"%s\", \"block\": %d, \"instances\": %d, \"callbacks\": %lld, "
+					"\"instance_mean_ns\": %.1f, \"instance_p99_ns\": %.1f, \"ns_per_sample\": %.3f, "
+					"\"relative\": %.3f, \"max_load\": %.4f, \"working_set_kb\": %.1f, \"instance_kb\": %.1f, \"shared_kb\": %.1f",
+					first ? "" : ",", os, linear ? "r8b" : "fir", block, count, r.callbacks,
+					r.meanNs, r.p99Ns, r.meanNs / (double)(block * opt.channels),
+					r.meanNs / single, r.maxLoad, count * (r.instanceKb + r.ioKb) + r.sharedKb, r.instanceKb, r.sharedKb);
+
+				if (r.counters.valid[PerfCounters::kLLCMisses] && r.countedSamples > 0.0)
+					fprintf(file, ", \"llc_misses_per_sample\": %.4f", r.counters.count[PerfCounters::kLLCMisses] / r.countedSamples);
+				else
+					fprintf(file, ", \"llc_misses_per_sample\": null");
+				fprintf(file, "}");
+				fflush(file);
+				first = false;
+			}
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	if (file != stdout) fclose(file);
+	return 0;
+}
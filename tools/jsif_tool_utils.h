@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// Helpers shared by the command line tools: option lists, the OS mapping
+// and the test signal.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "JSIF_dsp_types.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace yg331 {
+
+inline overSample toOverSample(int os)
+{
+	switch (os) {
+	case 2:  return overSample_2x;
+	case 4:  return overSample_4x;
+	case 8:  return overSample_8x;
+	default: return overSample_1x;
+	}
+}
+
+// pink-ish noise plus a sine at -6 dBFS, louder than 0 dBFS peaks so clip does work
+template <typename SampleType>
+void fillSignal(std::vector<std::vector<SampleType>>& buffers, double sampleRate)
+{
+	std::mt19937 rng(331);
+	std::uniform_real_distribution<double> dist(-1.0, 1.0);
+	for (size_t ch = 0; ch < buffers.size(); ch++)
+	{
+		double lp = 0.0;
+		for (size_t i = 0; i < buffers[ch].size(); i++)
+		{
+			lp = 0.9 * lp + 0.1 * dist(rng);
+			double sine = 0.5 * std::sin(2.0 * M_PI * 440.0 * (double)i / sampleRate);
+			buffers[ch][i] = (SampleType)(sine + 2.0 * lp);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+inline std::vector<std::string> splitList(const char* arg)
+{
+	std::vector<std::string> items;
+	std::string s(arg);
+	size_t start = 0;
+	while (start <= s.size())
+	{
+		size_t comma = s.find(',', start);
+		if (comma == std::string::npos) comma = s.size();
+		if (comma > start) items.push_back(s.substr(start, comma - start));
+		start = comma + 1;
+	}
+	return items;
+}
+
+inline std::vector<int> intList(const char* arg)
+{
+	std::vector<int> values;
+	for (auto& item : splitList(arg)) values.push_back(atoi(item.c_str()));
+	return values;
+}
+
+inline std::vector<bool> boolList(const char* arg, const char* trueName)
+{
+	std::vector<bool> values;
+	for (auto& item : splitList(arg))
+		values.push_back(item == "1" || item == "on" || item == "true" || item == trueName);
+	return values;
+}
+
+//------------------------------------------------------------------------
+} // namespace yg331
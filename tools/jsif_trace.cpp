@@ -0,0 +1,299 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// jsif_trace - timeline of JSIF_DSP::process() as a Chrome trace.
+//
+// Renders a test signal through every requested mode and records the spans
+// the profiling hooks report to a JSIF_Profiler::SpanSink: one per block,
+// per channel and per stage (upsample, shape, downsample) plus the
+// metering. The stages interleave sample by sample, so each stage span is
+// that stage's sum over the channel, laid out end to end from the start of
+// the channel. A single stage call that takes longer than --call-threshold
+// gets a span of its own on a separate track, in linear phase mode that
+// shows where r8brain fills and convolves its internal buffers. With
+// --threads channels after the first one run on a ChannelWorker, as in
+// offline rendering, and show up on their own tracks.
+//
+// Needs jsif_dsp built with -DJSIF_ENABLE_PROFILING=ON. Open the result in
+// chrome://tracing or https://ui.perfetto.dev.
+//
+//   jsif_trace [--out trace.json] [--os 1,2,4,8] [--phase fir,r8b]
+//              [--split 0,1] [--clip 0,1] [--channels N] [--block N]
+//              [--blocks N] [--rate HZ] [--threads] [--call-threshold US]
+//------------------------------------------------------------------------
+
+#include "JSIF_dsp.h"
+#include "jsif_tool_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace yg331;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------
+struct Config
+{
+	int  os      = 1;
+	bool linear  = false;
+	bool split   = false;
+	bool clip    = false;
+};
+
+struct Options
+{
+	std::vector<int>  os            = { 1, 2, 4, 8 };
+	std::vector<bool> linear        = { false, true };
+	std::vector<bool> split         = { false, true };
+	std::vector<bool> clip          = { false };
+	int               channels      = 2;
+	int               block         = 512;
+	int               blocks        = 32;
+	double            sampleRate    = 48000.0;
+	bool              threads       = false;
+	double            callThreshold = 5.0;  // microseconds
+	std::string       out;
+};
+
+std::string modeName(const Config& c)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "x%d %s%s%s", c.os, c.linear ? "r8b" : "fir",
+	         c.split ? " split" : "", c.clip ? " clip" : "");
+	return name;
+}
+
+//------------------------------------------------------------------------
+// Spans are kept per channel, a channel only ever runs on one thread at a
+// time and the all-channel spans only on the audio thread, so no locking.
+class Tracer : public JSIF_Profiler::SpanSink
+{
+public:
+	enum Track { kAudio = 0, kWorker, kAudioCalls, kWorkerCalls, kNumTracks };
+
+	Tracer(int channels, double callThresholdUs)
+		: perChannel(channels + 1), audioThread(std::this_thread::get_id()),
+		  originTicks(JSIF_Profiler::ticks()), originClock(clock_type::now())
+	{
+		callUs = callThresholdUs;
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		calibrate();
+	}
+
+	void span(const JSIF_Profiler::Span& s) override
+	{
+		bool worker = std::this_thread::get_id() != audioThread;
+		bool call   = s.stage >= 0 && s.channel >= 0 && !s.total;
+		Track track = (Track)((worker ? kWorker : kAudio) + (call ? kAudioCalls : 0));
+		perChannel[s.channel + 1].push_back({ s, mode, track });
+	}
+
+	// ticks per microsecond since construction, the call threshold follows it
+	void calibrate()
+	{
+		double us = std::chrono::duration<double, std::micro>(clock_type::now() - originClock).count();
+		uint64_t ticks = JSIF_Profiler::ticks() - originTicks;
+		if (us > 0.0 && ticks > 0) ticksPerUs = (double)ticks / us;
+		callTicks = (uint64_t)(callUs * ticksPerUs);
+	}
+
+	void reserve(size_t count)
+	{
+		for (auto& s : perChannel) s.reserve(s.size() + count);
+	}
+
+	int32_t addMode(const Config& c, int32_t frames)
+	{
+		modes.push_back({ c, frames });
+		return mode = (int32_t)modes.size() - 1;
+	}
+
+	void write(FILE* file, int channels);
+
+private:
+	struct Mode { Config config; int32_t frames; };
+	struct Entry { JSIF_Profiler::Span span; int32_t mode; Track track; };
+
+	std::vector<std::vector<Entry>> perChannel;  // [0] holds the all-channel spans
+	std::vector<Mode> modes;
+	int32_t mode = 0;
+
+	const std::thread::id audioThread;
+	const uint64_t originTicks;
+	const clock_type::time_point originClock;
+	double ticksPerUs = 1000.0;
+	double callUs = 5.0;
+};
+
+void Tracer::write(FILE* file, int channels)
+{
+	static const char* trackNames[kNumTracks] = { "audio", "channel worker", "audio slow calls", "channel worker slow calls" };
+
+	calibrate();
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"tool\":\"jsif_trace\",\"channels\":%d,\"ticks_per_us\":%.3f},\"traceEvents\":[\n",
+	        channels, ticksPerUs);
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"jsif_dsp\"}}");
+	for (int t = 0; t < kNumTracks; t++)
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", t + 1, trackNames[t]);
+
+	for (const auto& entries : perChannel)
+	{
+		for (const Entry& e : entries)
+		{
+			const JSIF_Profiler::Span& s = e.span;
+			const Mode& m = modes[e.mode];
+			const char* cat = s.stage == JSIF_Profiler::kBlockSpan   ? "block"
+			                : s.stage == JSIF_Profiler::kChannelSpan ? "channel"
+			                : (e.track >= kAudioCalls)              ? "call" : "stage";
+			fprintf(file,
+				",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"mode\":\"%s\",\"os\":%d,\"phase\":\"%s\","
+				"\"split\":%s,\"clip\":%s,\"block_size\":%d,\"block\":%llu",
+				JSIF_Profiler::stageName(s.stage), cat, e.track + 1,
+				(double)(int64_t)(s.begin - originTicks) / ticksPerUs, (double)(s.end - s.begin) / ticksPerUs,
+				modeName(m.config).c_str(), s.oversampling, s.linearPhase ? "r8b" : "fir",
+				m.config.split ? "true" : "false", m.config.clip ? "true" : "false",
+				m.frames, (unsigned long long)s.block);
+			if (s.channel >= 0)
+				fprintf(file, ",\"channel\":%d", s.channel);
+			if (s.total)
+				fprintf(file, ",\"sum\":true");
+			fprintf(file, "}}");
+		}
+	}
+	fprintf(file, "\n]}\n");
+}
+
+//------------------------------------------------------------------------
+void configure(JSIF_DSP& dsp, const Config& c, const Options& opt)
+{
+	dsp.prepare(opt.sampleRate, opt.channels, opt.block);
+	dsp.setInput(0.5);
+	dsp.setEffect(1.0);
+	dsp.setCurve(0.5);
+	dsp.setOutput(1.0);
+	dsp.setOverSample(toOverSample(c.os));
+	dsp.setLinearPhase(c.linear);
+	dsp.setSplit(c.split);
+	dsp.setClip(c.clip);
+	dsp.setIn(true);
+	dsp.setBypass(false);
+}
+
+// Renders all blocks of one mode through JSIF_DSP::process() with the tracer as sink
+void traceMode(const Options& opt, const Config& c, Tracer& tracer)
+{
+	const int32_t frames   = opt.block;
+	const int32_t channels = opt.channels;
+	const size_t  total    = (size_t)frames * opt.blocks;
+
+	std::vector<std::vector<double>> audio(channels, std::vector<double>(total));
+	fillSignal(audio, opt.sampleRate);
+
+	JSIF_DSP dsp;
+	configure(dsp, c, opt);
+	dsp.setChannelThreads(opt.threads);
+
+	tracer.addMode(c, frames);
+	tracer.reserve((size_t)opt.blocks * 8);
+	dsp.getProfiler().setSpanSink(&tracer);
+
+	std::vector<double*> ptr(channels);
+	for (int32_t b = 0; b < opt.blocks; b++)
+	{
+		for (int32_t ch = 0; ch < channels; ch++)
+			ptr[ch] = audio[ch].data() + (size_t)b * frames;
+		dsp.process(ptr.data(), ptr.data(), channels, frames);
+	}
+	dsp.getProfiler().setSpanSink(nullptr);
+}
+
+//------------------------------------------------------------------------
+void usage()
+{
+	fprintf(stderr,
+		"usage: jsif_trace [options]\n"
+		"  --out FILE            write the trace to FILE instead of stdout\n"
+		"  --os LIST             oversampling factors, e.g. 1,2,4,8\n"
+		"  --phase LIST          fir,r8b\n"
+		"  --split LIST          0,1\n"
+		"  --clip LIST           0,1 (default 0)\n"
+		"  --channels N          channel count (default 2)\n"
+		"  --block N             samples per block (default 512)\n"
+		"  --blocks N            blocks per mode (default 32)\n"
+		"  --rate HZ             sample rate (default 48000)\n"
+		"  --threads             process channels after the first on a worker thread\n"
+		"  --call-threshold US   record stage calls slower than US microseconds (default 5)\n");
+}
+
+bool parse(int argc, char* argv[], Options& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		const char* v = nullptr;
+
+		if      (a == "--threads") opt.threads = true;
+		else if (a == "--help" || a == "-h") { usage(); exit(0); }
+		else if ((v = next()) == nullptr) { usage(); return false; }
+		else if (a == "--out")            opt.out = v;
+		else if (a == "--os")             opt.os = intList(v);
+		else if (a == "--phase")          opt.linear = boolList(v, "r8b");
+		else if (a == "--split")          opt.split = boolList(v, "split");
+		else if (a == "--clip")           opt.clip = boolList(v, "clip");
+		else if (a == "--channels")       opt.channels = std::max(1, atoi(v));
+		else if (a == "--block")          opt.block = std::max(1, atoi(v));
+		else if (a == "--blocks")         opt.blocks = std::max(1, atoi(v));
+		else if (a == "--rate")           opt.sampleRate = atof(v);
+		else if (a == "--call-threshold") opt.callThreshold = atof(v);
+		else { usage(); return false; }
+	}
+	return true;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options opt;
+	if (!parse(argc, argv, opt))
+		return 1;
+
+	Tracer tracer(opt.channels, opt.callThreshold);
+
+	for (int os : opt.os)
+	for (bool linear : opt.linear)
+	{
+		// 1x has no oversampler, phase makes no difference
+		if (os == 1 && linear && opt.linear.size() > 1) continue;
+
+		for (bool split : opt.split)
+		for (bool clip : opt.clip)
+		{
+			Config c;
+			c.os = os; c.linear = linear; c.split = split; c.clip = clip;
+			traceMode(opt, c, tracer);
+		}
+	}
+
+	FILE* file = stdout;
+	if (!opt.out.empty() && (file = fopen(opt.out.c_str(), "w")) == nullptr)
+	{
+		fprintf(stderr, "jsif_trace: cannot open %s\n", opt.out.c_str());
+		return 1;
+	}
+	tracer.write(file, opt.channels);
+	if (file != stdout) fclose(file);
+
+	return 0;
+}
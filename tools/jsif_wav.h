@@ -0,0 +1,533 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 yg331.
+//------------------------------------------------------------------------
+// WAV and RF64 (EBU Tech 3306) file I/O for the command line tools.
+//
+// WavReader accepts RIFF and RF64, integer PCM of 8, 16, 24 and 32 bits
+// and IEEE float of 32 and 64 bits, also as WAVE_FORMAT_EXTENSIBLE. Other
+// chunks are skipped. WavWriter writes 32 or 64 bit float and reserves a
+// JUNK chunk after the header, which becomes the ds64 chunk when the data
+// outgrows 4 GB, so files of any length are written in one pass.
+//
+// Samples are read and written in blocks through planar double buffers,
+// memory does not depend on the file length. Little endian hosts only.
+//
+// MappedWavReader and MappedWavWriter do the same on memory mapped files:
+// each block is deinterleaved straight from the mapped input pages and
+// interleaved straight into the mapped output, without stream buffers.
+// Finished ranges are released every kReleaseBytes so the resident set
+// and the dirty page cache stay small on long files.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "jsif_mmap.h"
+
+namespace yg331 {
+
+//------------------------------------------------------------------------
+struct WavFormat
+{
+	int32_t channels   = 0;
+	double  sampleRate = 0.0;
+	int32_t bits       = 0;      // per sample
+	bool    isFloat    = false;
+	int32_t blockAlign = 0;      // bytes per frame
+};
+
+namespace wav {
+
+inline int fileSeek(FILE* file, uint64_t offset)
+{
+#if defined(_WIN32)
+	return _fseeki64(file, (long long)offset, SEEK_SET);
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+inline uint64_t fileTell(FILE* file)
+{
+#if defined(_WIN32)
+	return (uint64_t)_ftelli64(file);
+#else
+	return (uint64_t)ftello(file);
+#endif
+}
+
+inline uint16_t get16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+inline uint32_t get32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint64_t get64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+
+inline void put16(std::vector<uint8_t>& out, uint16_t v) { uint8_t b[2]; memcpy(b, &v, 2); out.insert(out.end(), b, b + 2); }
+inline void put32(std::vector<uint8_t>& out, uint32_t v) { uint8_t b[4]; memcpy(b, &v, 4); out.insert(out.end(), b, b + 4); }
+inline void put64(std::vector<uint8_t>& out, uint64_t v) { uint8_t b[8]; memcpy(b, &v, 8); out.insert(out.end(), b, b + 8); }
+inline void putTag(std::vector<uint8_t>& out, const char* tag) { out.insert(out.end(), tag, tag + 4); }
+
+/** Interleaved file samples to planar doubles, frames starting at planar[ch] + offset. */
+inline void decode(const uint8_t* src, const WavFormat& format, double* const* planar, int64_t offset, int64_t frames)
+{
+	const int32_t channels = format.channels;
+	const int32_t bytes    = format.bits / 8;
+	for (int64_t i = 0; i < frames; i++)
+	{
+		for (int32_t ch = 0; ch < channels; ch++, src += bytes)
+		{
+			double v;
+			if (format.isFloat)
+			{
+				if (bytes == 4) { float f; memcpy(&f, src, 4); v = f; }
+				else            { double d; memcpy(&d, src, 8); v = d; }
+			}
+			else if (bytes == 1) v = ((int)src[0] - 128) / 128.0;
+			else if (bytes == 2) v = (int16_t)get16(src) / 32768.0;
+			else if (bytes == 3) v = (int32_t)((uint32_t)src[0] << 8 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 24) / 2147483648.0;
+			else                 v = (int32_t)get32(src) / 2147483648.0;
+			planar[ch][offset + i] = v;
+		}
+	}
+}
+
+/** Planar doubles to interleaved 32 or 64 bit float. */
+inline void encode(const double* const* planar, int64_t offset, int64_t frames, int32_t channels, int32_t bits, uint8_t* dst)
+{
+	for (int64_t i = 0; i < frames; i++)
+		for (int32_t ch = 0; ch < channels; ch++)
+		{
+			double v = planar[ch][offset + i];
+			if (bits == 64) { memcpy(dst, &v, 8); dst += 8; }
+			else            { float f = (float)v; memcpy(dst, &f, 4); dst += 4; }
+		}
+}
+
+/** Float format description for the writers, bits is 32 or 64. */
+inline WavFormat floatFormat(int32_t channels, double sampleRate, int32_t bits)
+{
+	WavFormat fmt;
+	fmt.channels   = channels;
+	fmt.sampleRate = sampleRate;
+	fmt.bits       = (bits == 64) ? 64 : 32;
+	fmt.isFloat    = true;
+	fmt.blockAlign = channels * fmt.bits / 8;
+	return fmt;
+}
+
+/** The complete header for a file holding dataSize bytes of samples, RF64 when RIFF
+ *  cannot hold it. The size does not depend on dataSize, samples start right after. */
+inline std::vector<uint8_t> makeHeader(const WavFormat& fmt, uint64_t dataSize)
+{
+	const bool extensible = fmt.channels > 2;
+	const uint64_t frames = dataSize / (uint64_t)fmt.blockAlign;
+	const uint64_t headerSize = extensible ? 116 : 94;
+	const uint64_t riffSize   = headerSize + dataSize + (dataSize & 1) - 8;
+	const bool rf64 = riffSize > 0xFFFFFFFFull;
+	std::vector<uint8_t> h;
+
+	putTag(h, rf64 ? "RF64" : "RIFF");
+	put32(h, rf64 ? 0xFFFFFFFFu : (uint32_t)riffSize);
+	putTag(h, "WAVE");
+
+	// ds64 when RF64, otherwise the same 28 bytes reserved as JUNK
+	putTag(h, rf64 ? "ds64" : "JUNK");
+	put32(h, 28);
+	put64(h, rf64 ? riffSize : 0);
+	put64(h, rf64 ? dataSize : 0);
+	put64(h, rf64 ? frames : 0);
+	put32(h, 0);
+
+	putTag(h, "fmt ");
+	put32(h, extensible ? 40 : 18);
+	put16(h, extensible ? 0xFFFE : 3);
+	put16(h, (uint16_t)fmt.channels);
+	put32(h, (uint32_t)fmt.sampleRate);
+	put32(h, (uint32_t)(fmt.sampleRate * fmt.blockAlign));
+	put16(h, (uint16_t)fmt.blockAlign);
+	put16(h, (uint16_t)fmt.bits);
+	if (extensible)
+	{
+		static const uint8_t floatGuid[16] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+		                                       0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+		put16(h, 22);
+		put16(h, (uint16_t)fmt.bits);
+		put32(h, 0);  // no speaker positions
+		h.insert(h.end(), floatGuid, floatGuid + 16);
+	}
+	else
+		put16(h, 0);
+
+	putTag(h, "fact");
+	put32(h, 4);
+	put32(h, rf64 ? 0xFFFFFFFFu : (uint32_t)frames);
+
+	putTag(h, "data");
+	put32(h, rf64 ? 0xFFFFFFFFu : (uint32_t)dataSize);
+	return h;
+}
+
+} // namespace wav
+
+//------------------------------------------------------------------------
+class WavReader
+{
+public:
+	WavReader() = default;
+	~WavReader() { close(); }
+
+	WavReader(const WavReader&) = delete;
+	WavReader& operator=(const WavReader&) = delete;
+
+	/** Opens and parses the header, on failure error says why. */
+	bool open(const std::string& path, std::string& error)
+	{
+		close();
+		file = fopen(path.c_str(), "rb");
+		if (!file) { error = "cannot open " + path; return false; }
+		if (!parseHeader(error)) { close(); return false; }
+		return true;
+	}
+
+	void close()
+	{
+		if (file) fclose(file);
+		file = nullptr;
+	}
+
+	const WavFormat& format() const { return fmt; }
+	uint64_t frames()     const { return totalFrames; }
+	uint64_t dataOffset() const { return dataStart; }
+
+	/** Reads up to `frames` frames to planar[ch][offset..], returns the frames read, 0 at the end. */
+	int64_t read(double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!file || position >= totalFrames) return 0;
+		frames = (int64_t)std::min<uint64_t>((uint64_t)frames, totalFrames - position);
+		raw.resize((size_t)(frames * fmt.blockAlign));
+		int64_t got = (int64_t)fread(raw.data(), (size_t)fmt.blockAlign, (size_t)frames, file);
+		wav::decode(raw.data(), fmt, planar, offset, got);
+		position += (uint64_t)got;
+		return got;
+	}
+
+	/** Moves the read position to a frame. */
+	bool seek(uint64_t frame)
+	{
+		if (!file || frame > totalFrames) return false;
+		if (wav::fileSeek(file, dataStart + frame * (uint64_t)fmt.blockAlign) != 0) return false;
+		position = frame;
+		return true;
+	}
+
+private:
+	bool parseHeader(std::string& error)
+	{
+		uint8_t head[12];
+		if (fread(head, 1, 12, file) != 12 || memcmp(head + 8, "WAVE", 4) != 0 ||
+		    (memcmp(head, "RIFF", 4) != 0 && memcmp(head, "RF64", 4) != 0))
+		{
+			error = "not a WAV or RF64 file";
+			return false;
+		}
+
+		uint64_t dataSize64 = 0;
+		bool haveFormat = false;
+		uint64_t offset = 12;
+		uint8_t chunk[8];
+		while (fread(chunk, 1, 8, file) == 8)
+		{
+			uint64_t size = wav::get32(chunk + 4);
+			offset += 8;
+
+			if (memcmp(chunk, "ds64", 4) == 0 || memcmp(chunk, "fmt ", 4) == 0)
+			{
+				std::vector<uint8_t> body((size_t)size);
+				if (size < 16 || fread(body.data(), 1, (size_t)size, file) != size) break;
+				if (memcmp(chunk, "ds64", 4) == 0)
+					dataSize64 = wav::get64(body.data() + 8);
+				else if (!parseFormat(body, error))
+					return false;
+				else
+					haveFormat = true;
+			}
+			else if (memcmp(chunk, "data", 4) == 0)
+			{
+				if (!haveFormat) break;
+				dataStart = offset;
+				fseek(file, 0, SEEK_END);
+				uint64_t available = wav::fileTell(file) - dataStart;
+				// RF64 keeps the size in ds64, streaming writers leave it unset
+				if (size == 0xFFFFFFFFu) size = dataSize64 ? dataSize64 : available;
+				// a file cut short
+				if (size > available) size = available;
+				totalFrames = size / (uint64_t)fmt.blockAlign;
+				return seek(0);
+			}
+			offset += size + (size & 1);
+			if (wav::fileSeek(file, offset) != 0)
+				break;
+		}
+		error = haveFormat ? "no data chunk" : "no fmt chunk";
+		return false;
+	}
+
+	bool parseFormat(const std::vector<uint8_t>& body, std::string& error)
+	{
+		uint16_t tag = wav::get16(&body[0]);
+		fmt.channels   = wav::get16(&body[2]);
+		fmt.sampleRate = (double)wav::get32(&body[4]);
+		fmt.blockAlign = wav::get16(&body[12]);
+		fmt.bits       = wav::get16(&body[14]);
+		if (tag == 0xFFFE && body.size() >= 26)
+			tag = wav::get16(&body[24]);  // first bytes of the sub format GUID
+
+		fmt.isFloat = (tag == 3);
+		bool pcm    = (tag == 1) && (fmt.bits == 8 || fmt.bits == 16 || fmt.bits == 24 || fmt.bits == 32);
+		bool ieee   = fmt.isFloat && (fmt.bits == 32 || fmt.bits == 64);
+		if (!(pcm || ieee) || fmt.channels < 1 || fmt.blockAlign != fmt.channels * fmt.bits / 8 || fmt.sampleRate <= 0.0)
+		{
+			error = "unsupported sample format (format " + std::to_string(tag) + ", " + std::to_string(fmt.bits) + " bits)";
+			return false;
+		}
+		return true;
+	}
+
+	FILE*     file = nullptr;
+	WavFormat fmt;
+	uint64_t  dataStart   = 0;
+	uint64_t  totalFrames = 0;
+	uint64_t  position    = 0;
+	std::vector<uint8_t> raw;
+};
+
+//------------------------------------------------------------------------
+class WavWriter
+{
+public:
+	WavWriter() = default;
+	~WavWriter() { close(); }
+
+	WavWriter(const WavWriter&) = delete;
+	WavWriter& operator=(const WavWriter&) = delete;
+
+	/** Creates the file and writes the header, bits is 32 or 64 (float). */
+	bool open(const std::string& path, int32_t channels, double sampleRate, int32_t bits, std::string& error)
+	{
+		close();
+		fmt  = wav::floatFormat(channels, sampleRate, bits);
+		file = fopen(path.c_str(), "wb");
+		if (!file) { error = "cannot create " + path; return false; }
+
+		std::vector<uint8_t> header = wav::makeHeader(fmt, 0);
+		if (fwrite(header.data(), 1, header.size(), file) != header.size())
+		{
+			error = "cannot write " + path;
+			close();
+			return false;
+		}
+		dataStart = header.size();
+		return true;
+	}
+
+	const WavFormat& format() const { return fmt; }
+	uint64_t frames()     const { return totalFrames; }
+	uint64_t dataOffset() const { return dataStart; }
+
+	/** Appends frames from planar[ch][offset..]. */
+	bool write(const double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!file || frames <= 0) return file != nullptr;
+		raw.resize((size_t)(frames * fmt.blockAlign));
+		wav::encode(planar, offset, frames, fmt.channels, fmt.bits, raw.data());
+		if (fwrite(raw.data(), 1, raw.size(), file) != raw.size()) return false;
+		totalFrames += (uint64_t)frames;
+		return true;
+	}
+
+	/** Patches the sizes, switching to RF64 when the data is larger than RIFF allows. */
+	bool close()
+	{
+		if (!file) return true;
+		uint64_t dataSize = totalFrames * (uint64_t)fmt.blockAlign;
+		bool ok = true;
+		if (dataSize & 1) ok &= (fputc(0, file) != EOF);
+
+		std::vector<uint8_t> header = wav::makeHeader(fmt, dataSize);
+		ok &= (wav::fileSeek(file, 0) == 0);
+		ok &= (fwrite(header.data(), 1, header.size(), file) == header.size());
+		ok &= (fclose(file) == 0);
+		file = nullptr;
+		return ok;
+	}
+
+private:
+	FILE*     file = nullptr;
+	WavFormat fmt;
+	uint64_t  dataStart   = 0;
+	uint64_t  totalFrames = 0;
+	std::vector<uint8_t> raw;
+};
+
+//------------------------------------------------------------------------
+class MappedWavReader
+{
+public:
+	static constexpr uint64_t kReleaseBytes = 16ull << 20;
+
+	/** Parses the header like WavReader, then maps the file. */
+	bool open(const std::string& path, std::string& error)
+	{
+		WavReader header;
+		if (!header.open(path, error)) return false;
+		fmt         = header.format();
+		dataStart   = header.dataOffset();
+		totalFrames = header.frames();
+		header.close();
+
+		if (!map.openRead(path, error)) return false;
+		if (map.size() < dataStart + totalFrames * (uint64_t)fmt.blockAlign)
+		{
+			error = "file changed while opening";
+			map.close();
+			return false;
+		}
+		position = 0;
+		released = 0;
+		return true;
+	}
+
+	void close() { map.close(); }
+
+	const WavFormat& format() const { return fmt; }
+	uint64_t frames()     const { return totalFrames; }
+	uint64_t dataOffset() const { return dataStart; }
+
+	int64_t read(double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!map.data() || position >= totalFrames) return 0;
+		frames = (int64_t)std::min<uint64_t>((uint64_t)frames, totalFrames - position);
+		uint64_t byte = dataStart + position * (uint64_t)fmt.blockAlign;
+		wav::decode(map.data() + byte, fmt, planar, offset, frames);
+		position += (uint64_t)frames;
+
+		uint64_t done = byte + (uint64_t)frames * (uint64_t)fmt.blockAlign;
+		if (done - released >= kReleaseBytes)
+		{
+			map.release(released, done - released);
+			released = done;
+		}
+		return frames;
+	}
+
+	bool seek(uint64_t frame)
+	{
+		if (!map.data() || frame > totalFrames) return false;
+		position = frame;
+		released = dataStart + frame * (uint64_t)fmt.blockAlign;
+		return true;
+	}
+
+private:
+	MappedFile map;
+	WavFormat  fmt;
+	uint64_t   dataStart   = 0;
+	uint64_t   totalFrames = 0;
+	uint64_t   position    = 0;
+	uint64_t   released    = 0;
+};
+
+//------------------------------------------------------------------------
+class MappedWavWriter
+{
+public:
+	static constexpr uint64_t kReleaseBytes = 16ull << 20;
+
+	~MappedWavWriter() { close(); }
+
+	/** Creates the file at its final size, `frames` is the length that will be written. */
+	bool open(const std::string& path, int32_t channels, double sampleRate, int32_t bits, uint64_t frames, std::string& error)
+	{
+		close();
+		fmt = wav::floatFormat(channels, sampleRate, bits);
+		plannedFrames = frames;
+		totalFrames   = 0;
+
+		uint64_t dataSize = frames * (uint64_t)fmt.blockAlign;
+		std::vector<uint8_t> header = wav::makeHeader(fmt, dataSize);
+		if (!map.create(path, header.size() + dataSize + (dataSize & 1), error)) return false;
+		memcpy(map.data(), header.data(), header.size());
+		dataStart = header.size();
+		released  = 0;
+		return true;
+	}
+
+	const WavFormat& format() const { return fmt; }
+	uint64_t frames()     const { return totalFrames; }
+	uint64_t dataOffset() const { return dataStart; }
+
+	bool write(const double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!writeAt(totalFrames, planar, offset, frames)) return false;
+		totalFrames += (uint64_t)frames;
+
+		uint64_t done = dataStart + totalFrames * (uint64_t)fmt.blockAlign;
+		if (done - released >= kReleaseBytes)
+		{
+			map.writeBack(released, done - released);
+			map.release(released, done - released);
+			released = done;
+		}
+		return true;
+	}
+
+	/** Writes at `frame` without moving write()'s position. Threads may write disjoint ranges at once. */
+	bool writeAt(uint64_t frame, const double* const* planar, int64_t offset, int64_t frames)
+	{
+		if (!map.data() || frames < 0 || frame + (uint64_t)frames > plannedFrames) return false;
+		uint64_t byte = dataStart + frame * (uint64_t)fmt.blockAlign;
+		wav::encode(planar, offset, frames, fmt.channels, fmt.bits, map.data() + byte);
+		return true;
+	}
+
+	/** Starts writing back frames written with writeAt() and drops them from the process. */
+	void releaseFrames(uint64_t frame, uint64_t frames)
+	{
+		uint64_t byte = dataStart + frame * (uint64_t)fmt.blockAlign;
+		map.writeBack(byte, frames * (uint64_t)fmt.blockAlign);
+		map.release(byte, frames * (uint64_t)fmt.blockAlign);
+	}
+
+	/** The first `frames` frames count as written, once writeAt() filled them all. */
+	void setWritten(uint64_t frames) { totalFrames = std::min(frames, plannedFrames); }
+
+	/** A file that got fewer frames than planned is cut to what was written. */
+	bool close()
+	{
+		if (!map.data()) return true;
+		uint64_t dataSize = totalFrames * (uint64_t)fmt.blockAlign;
+		uint64_t size     = dataStart + dataSize + (dataSize & 1);
+		if (totalFrames != plannedFrames)
+		{
+			std::vector<uint8_t> header = wav::makeHeader(fmt, dataSize);
+			memcpy(map.data(), header.data(), header.size());
+		}
+		if (dataSize & 1) map.data()[dataStart + dataSize] = 0;
+		return map.close(size);
+	}
+
+private:
+	MappedFile map;
+	WavFormat  fmt;
+	uint64_t   dataStart     = 0;
+	uint64_t   plannedFrames = 0;
+	uint64_t   totalFrames   = 0;
+	uint64_t   released      = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace yg331